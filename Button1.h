@@ -18,6 +18,7 @@
   int buttonBrightness = 250;
   int buttonPulsateTime = 1000;
   int buttonOffTime = 0;
+  byte interruptPin; // wired to the Qwiic Button INT pin, held low from a press until the event bits are cleared
 
   // public class methods
   public:
@@ -26,14 +27,19 @@
     {
     }
 
-    // class setup
-    void setup()
+    // class setup, interruptPin is wired to the Qwiic Button INT pin (PowerManager wakes on it)
+    void setup(byte interruptPin)
     {
+      this->interruptPin = interruptPin;
+      pinMode(interruptPin, INPUT_PULLUP);
       // Qwiic button setup
       if (button.begin() == false) {
-        Serial.println("Device did not acknowledge! Freezing.");
+        Serial.println(F("Device did not acknowledge! Freezing."));
       }
       this->button.LEDoff();  // start with the LED off
+      // pull the INT pin low on press, used to wake from idle mode
+      this->button.enablePressedInterrupt();
+      this->button.clearEventBits();
     }
 
     // class loop
@@ -63,6 +69,12 @@
           }
         }
       }
+
+      // the press is over, whatever it turned out to be (or one we never saw while asleep): release the INT pin
+      // so the next press makes a new falling edge for PowerManager, the GPIO read first keeps I2C traffic down
+      if (digitalRead(this->interruptPin) == LOW && this->button.isPressed() == false) {
+        this->button.clearEventBits();
+      }
     }
 
     bool getIsShortClicked()
@@ -82,6 +94,7 @@
       this->isShortClicked = false;
       this->isLongPressed = false;
       this->button.LEDoff();
+      this->button.clearEventBits(); // release the INT pin
     }
   private:
     //
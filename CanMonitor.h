@@ -0,0 +1,257 @@
+/*
+ * CanMonitor.h - Listen to broadcast CAN frames with the SparkFun OBD-II UART (STN1110) instead of polling PIDs
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ // Good to know: broadcast IDs and bit layouts are vehicle specific, see https://github.com/commaai/opendbc for many cars
+ // Only 11-bit IDs are handled for now (29-bit headers print as four space separated bytes and can't be told apart from data)
+
+ #ifndef CanMonitor_h
+ #define CanMonitor_h
+
+ #include <Arduino.h>
+
+ #include "Obd2.h" // PID constants, and Obd2 has to let go of the UART while monitoring
+ #include "SampleBus.h" // decoded signals are published here like any polled reading
+
+ // one signal inside a broadcast frame, supplied by the sketch with the start bit, length and byte order of its DBC line
+ // (SG_ NAME : startBit|length@order...), so opendbc entries can be copied as they are
+ // DBC numbers bits 0-7 from the LSB of data byte 0, 8-15 in byte 1 and so on
+ // Intel (@1) signals start at their LSB and run up, Motorola (@0) signals start at their MSB and run down into the next byte:
+ // SPEED : 47|16@0+ is byte 5 bit 7 down to byte 6 bit 0
+ struct CanSignal {
+   unsigned int id; // 11-bit arbitration ID
+   byte startBit; // DBC start bit: the signal's LSB (Intel) or MSB (Motorola)
+   byte length; // bits
+   bool bigEndian; // Motorola (true, @0) or Intel (false, @1) byte order
+   bool isSigned; // two's complement
+   float scale; // value = raw * scale + offset
+   int offset;
+   byte pid; // publish as this PID, e.g. Obd2::SPEED, so existing subscribers get it for free
+ };
+
+ class CanMonitor {
+  // define class variables
+  Obd2& obd2; // reference shared Obd2 instance
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  Stream& port; // OBD-II UART shared with Obd2, begun by the caller: Serial1 in the car, a scripted stream in tests
+  const CanSignal* signals; // ID/bit layout table
+  byte signalCount;
+  const static byte maxCharsPerLoop = 64; // don't let a busy bus hold up the rest of loop()
+  bool monitoring = false;
+  unsigned long frameCount = 0; // frames decoded
+  unsigned long badLineCount = 0; // lines that weren't frames (prompts, BUFFER FULL...)
+
+  // streaming parser state, one character at a time, no line buffer
+  unsigned int tokenValue = 0; // hex value of the token so far
+  byte tokenLength = 0; // hex digits in the token so far
+  byte tokenIndex = 0; // 0 = ID, 1+ = data bytes
+  unsigned int frameId;
+  byte frameData[8];
+  byte frameLength = 0;
+  bool lineValid = true;
+
+  // public class methods
+  public:
+    // constructor
+    CanMonitor(Obd2 &obd2, SampleBus &sampleBus, const CanSignal* signals, byte signalCount, Stream &port):
+      // member initializer list
+      obd2(obd2),
+      sampleBus(sampleBus),
+      port(port),
+      signals(signals),
+      signalCount(signalCount)
+    {
+    }
+
+    // put the adapter in filtered monitor mode, passing only the IDs in the signal table
+    // blocks for a moment like Obd2::setup(), call on boot and when leaving idle mode
+    void start()
+    {
+      if (this->monitoring == true || this->obd2.isBusy()) {
+        return;
+      }
+      this->obd2.setMonitoring(true);
+      this->sendCommand("STFAC"); // clear all filters
+      for (byte i=0; i<this->signalCount; i++)
+      {
+        char command[20];
+        sprintf(command, "STFAP %03X,7FF", this->signals[i].id); // pass this ID exactly
+        this->sendCommand(command);
+      }
+      this->sendCommand("ATH1"); // show IDs
+      this->sendCommand("ATCAF0"); // show all data bytes as sent
+      this->port.println("STM"); // monitor using the filters above until any character is sent
+      this->resetLine();
+      this->monitoring = true;
+    }
+
+    // leave monitor mode and give the UART back to Obd2
+    void stop()
+    {
+      if (this->monitoring == false) {
+        return;
+      }
+      this->port.println(); // any character stops monitoring
+      delay(100);
+      this->drainResponse();
+      this->sendCommand("ATCAF1");
+      this->sendCommand("ATH0");
+      this->monitoring = false;
+      this->obd2.setMonitoring(false);
+    }
+
+    // class loop
+    void loop()
+    {
+      if (this->monitoring == false) {
+        return;
+      }
+      for (byte i=0; i<maxCharsPerLoop && this->port.available() > 0; i++)
+      {
+        this->feed(this->port.read());
+      }
+    }
+
+    // parse one character of monitor output, e.g. "0B4 00 00 00 00 8E 0F 52 BC\r"
+    void feed(char c)
+    {
+      if (isHexadecimalDigit(c)) {
+        this->tokenValue = this->tokenValue * 16 + (c <= '9' ? c - '0' : (c & 0xDF) - 'A' + 10);
+        this->tokenLength += 1;
+        // IDs have up to 3 digits, data bytes 2
+        if (this->tokenLength > (this->tokenIndex == 0 ? 3 : 2)) {
+          this->lineValid = false;
+        }
+      } else if (c == ' ') {
+        this->endToken();
+      } else if (c == '\r' || c == '\n') {
+        this->endToken();
+        this->endLine();
+      } else {
+        // prompts and messages like BUFFER FULL or STOPPED
+        this->lineValid = false;
+      }
+    }
+
+    unsigned long getFrameCount()
+    {
+      return this->frameCount;
+    }
+
+    unsigned long getBadLineCount()
+    {
+      return this->badLineCount;
+    }
+
+  // private class methods
+  private:
+    // send a setup command and wait for the adapter to finish with it
+    void sendCommand(const char* command)
+    {
+      this->port.println(command);
+      delay(100);
+      this->drainResponse();
+    }
+
+    // throw away whatever the adapter said (OK, ?, the > prompt...)
+    void drainResponse()
+    {
+      while (this->port.available() > 0) {
+        this->port.read();
+      }
+    }
+
+    void endToken()
+    {
+      if (this->tokenLength == 0) {
+        return;
+      }
+      if (this->tokenIndex == 0) {
+        this->frameId = this->tokenValue;
+      } else if (this->frameLength < 8) {
+        this->frameData[this->frameLength++] = this->tokenValue;
+      } else {
+        this->lineValid = false;
+      }
+      this->tokenIndex += 1;
+      this->tokenValue = 0;
+      this->tokenLength = 0;
+    }
+
+    void endLine()
+    {
+      if (this->tokenIndex == 0) {
+        // empty line
+      } else if (this->lineValid && this->frameLength > 0) {
+        this->decodeFrame();
+      } else {
+        this->badLineCount += 1;
+      }
+      this->resetLine();
+    }
+
+    void resetLine()
+    {
+      this->tokenValue = 0;
+      this->tokenLength = 0;
+      this->tokenIndex = 0;
+      this->frameLength = 0;
+      this->lineValid = true;
+    }
+
+    // publish every signal in the table carried by this frame
+    void decodeFrame()
+    {
+      this->frameCount += 1;
+      this->obd2.markCarActivity();
+      for (byte i=0; i<this->signalCount; i++)
+      {
+        const CanSignal &signal = this->signals[i];
+        if (signal.id != this->frameId || this->firstBit(signal) + signal.length > this->frameLength * 8) {
+          continue;
+        }
+        Sample sample;
+        sample.pid = signal.pid;
+        sample.timestamp = millis();
+        sample.value = round(this->extract(signal) * signal.scale + signal.offset);
+        this->sampleBus.publish(sample);
+      }
+    }
+
+    // the signal's lowest bit in a count that runs in the order it's read: Intel signals count up from their DBC start bit,
+    // Motorola signals are counted from the MSB of data byte 0 so each one is a run of sequential bits
+    byte firstBit(const CanSignal &signal)
+    {
+      if (signal.bigEndian) {
+        return (signal.startBit / 8) * 8 + 7 - signal.startBit % 8;
+      }
+      return signal.startBit;
+    }
+
+    // pull a signal's raw value out of the frame, MSB first
+    long extract(const CanSignal &signal)
+    {
+      unsigned long raw = 0;
+      byte first = this->firstBit(signal);
+      for (byte i=0; i<signal.length; i++)
+      {
+        byte bit;
+        if (signal.bigEndian) {
+          // MSB first from the start bit, counted from the MSB of byte 0
+          bit = first + i;
+          raw = (raw << 1) | ((this->frameData[bit / 8] >> (7 - bit % 8)) & 1);
+        } else {
+          // start bit is the LSB, walk down from the MSB
+          bit = first + signal.length - 1 - i;
+          raw = (raw << 1) | ((this->frameData[bit / 8] >> (bit % 8)) & 1);
+        }
+      }
+      if (signal.isSigned && signal.length < 32 && (raw >> (signal.length - 1)) & 1) {
+        return (long) raw - (1L << signal.length);
+      }
+      return raw;
+    }
+};
+
+#endif
@@ -14,56 +14,49 @@
  #include <SparkFun_Qwiic_OpenLog_Arduino_Library.h>
 
  #include "RtcUtils.h" // format dates for logs
- #include "Obd2.h" // Communicate with the car via SparkFun Car OBD-II UART
+ #include "Obd2.h" // PID constants for the readings we log
+ #include "SampleBus.h" // readings arrive here from Obd2 instead of requesting them ourselves
  
- class DataLogger {
+ // the RTC and log are template parameters so benchmarks can swap in ScriptedRtc and ScriptedOpenLog
+ template <class Rtc = RV1805, class Log = OpenLog>
+ class DataLogger : public SampleSubscriber {
   // define class variables
-  RV1805& rtc; // reference shared RTC clock instance
-  OpenLog& openLog; // reference shared OpenLog instance
-  Obd2& obd2; // reference shared Obd2 instance
+  Rtc& rtc; // reference shared RTC clock instance
+  Log& openLog; // reference shared OpenLog instance
+  SampleBus& sampleBus; // reference shared SampleBus instance
   RtcUtils rtcUtils; // create RTC utils instance
-  unsigned long startTime; // milliseconds to start timing from (no RTC required, based on milliseconds since Arduino start)
-  unsigned long curTime; // current milliseconds
-  const static unsigned long idlePeriod = 600000; // 10 minutes
+  const static unsigned long idlePeriod = 600000; // 10 minutes between readings of each PID
   const static int logCount = 15; // logging 15 different readings from OBD-II UART
-  int logIndex = 0; // only going to log one reading at a time per loop to prevent major lag
-  String rtcDateTime; // last RTC date/time for log
-  bool logBusy = false; // OpenLog will take about 15ms to write, moving along in the loop while waiting
-  const static int logBusyPeriod = 30; // 30ms 
-  unsigned long logBusyStartTime;
-  // log each data point type separately
-  const char logFiles[logCount][40];
-
-  // manage loop based on state of data retreival, skipping loops when waiting instead of using delay() to wait for data for a "faster" app
-  const static int DATA_STATE_REQUESTING = 0;
-  const static int DATA_STATE_WRITING = 1;
-  const static int DATA_STATE_READY = 2;
-  int dataState = DATA_STATE_READY;
+  // PIDs logged, matching getLogFile() by index
+  const byte logPids[logCount];
 
   // public class methods
   public:
+    // subscriptions made in setup(), the sketch sizes SampleBus from these
+    const static byte sampleSubscriptionCount = logCount;
+
     // constructor
-    DataLogger(RV1805 &rtc, OpenLog &openLog, Obd2 &obd2): 
+    DataLogger(Rtc &rtc, Log &openLog, SampleBus &sampleBus): 
       // member initializer list
       rtc(rtc),
       openLog(openLog),
-      obd2(obd2),
-      logFiles {
-        "stfueltrimb1.txt",
-        "ltfueltrimb1.txt",
-        "stfueltrimb2.txt",
-        "ltfueltrimb2.txt",
-        "speed.txt",
-        "intaketemp.txt",
-        "runtimeenginestart.txt",
-        "distancewithmil.txt",
-        "warmupssincecleared.txt",
-        "distancesincecleared.txt",
-        "absbarampressure.txt",
-        "absload.txt",
-        "timerunwithmil.txt",
-        "timesincecleared.txt",
-        "absevapvaporpressure.txt"
+      sampleBus(sampleBus),
+      logPids {
+        Obd2::SHORT_TERM_FUEL_TRIM_BANK_1,
+        Obd2::LONG_TERM_FUEL_TRIM_BANK_1,
+        Obd2::SHORT_TERM_FUEL_TRIM_BANK_2,
+        Obd2::LONG_TERM_FUEL_TRIM_BANK_2,
+        Obd2::SPEED,
+        Obd2::AIR_INTAKE_TEMP,
+        Obd2::RUN_TIME_SINCE_ENGINE_START,
+        Obd2::DISTANCE_WITH_MIL_ON,
+        Obd2::WARMUPS_SINCE_CODES_CLEARED,
+        Obd2::DISTANCE_SINCE_CODES_CLEARED,
+        Obd2::ABSOLUTE_BARAMETRIC_PRESSURE,
+        Obd2::ABSOLUTE_LOAD_VALUE,
+        Obd2::TIME_RUN_WITH_MIL_ON,
+        Obd2::TIME_SINCE_TROUBLE_CODES_CLEARED,
+        Obd2::ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE
       }
     {
     }
@@ -72,148 +65,79 @@
     void setup()
     {
       Serial.begin(9600);
-      this->startTime = millis();
-      this->curTime = millis();
+      for (int i=0; i<logCount; i++)
+      {
+        this->sampleBus.subscribe(*this, this->logPids[i], idlePeriod);
+      }
     }
 
     // class loop
     void loop()
     {
-      if (this->dataState == DATA_STATE_READY) {
-        // There is no active request or log write happening: wait for next set of log readings to occur
-        this->curTime = millis();
-        if (this->curTime - this->startTime >= this->idlePeriod) {
-          this->dataState = DATA_STATE_REQUESTING;
-          this->requestDataPoint();
-        }
-      } else if (this->dataState == DATA_STATE_REQUESTING) {
-        // skip this loop immediately if there's an pending OBD2 request that's busy
-        if(this->obd2.isBusy()) {
-          return;
-        }
+      // nothing to do here, readings arrive through onSample()
+    }
 
-        // log requested data
-        this->dataState = DATA_STATE_WRITING;
-        this->logDataPoint();
-      } else if (this->dataState == DATA_STATE_WRITING) {
-        // skip this loop immediately if OpenLog is writing data from last request
-        if (this->isLogBusy()) {
+    // log a reading published by Obd2 with date/time
+    // Obd2 publishes at most one reading per 200ms request, giving OpenLog plenty of time to finish each write
+    void onSample(const Sample &sample)
+    {
+      for (int i=0; i<logCount; i++)
+      {
+        if (this->logPids[i] == sample.pid) {
+          this->logDataPoint(i, sample.value);
           return;
         }
-
-        // get ready to request the next data point or wait for a period if all data points were requested/logged
-        this->dataState = DATA_STATE_READY;
-        this->logIndex += 1;
-        if (this->logIndex >= this->logCount) {
-          this->logIndex = 0;
-          this->startTime = millis();
-        }
       }
     }
 
   // private class methods
   private:
-    // make a request to get data, collected later to prevent blocking the loop (takes some time)
-    void requestDataPoint()
-    {
-      switch(this->logIndex)
-      {
-        case 0:
-          this->obd2.makePidRequest(this->obd2.SHORT_TERM_FUEL_TRIM_BANK_1);
-          break;
-        case 1:
-          this->obd2.makePidRequest(this->obd2.LONG_TERM_FUEL_TRIM_BANK_1);
-          break;
-        case 2:
-          this->obd2.makePidRequest(this->obd2.SHORT_TERM_FUEL_TRIM_BANK_2);
-          break;
-        case 3:
-          this->obd2.makePidRequest(this->obd2.LONG_TERM_FUEL_TRIM_BANK_2);
-          break;
-        case 4:
-          this->obd2.makePidRequest(this->obd2.SPEED);
-          break;
-        case 5:
-          this->obd2.makePidRequest(this->obd2.AIR_INTAKE_TEMP);
-          break;
-        case 6:
-          this->obd2.makePidRequest(this->obd2.RUN_TIME_SINCE_ENGINE_START);
-          break;
-        case 7:
-          this->obd2.makePidRequest(this->obd2.DISTANCE_WITH_MIL_ON);
-          break;
-        case 8:
-          this->obd2.makePidRequest(this->obd2.WARMUPS_SINCE_CODES_CLEARED);
-          break;
-        case 9:
-          this->obd2.makePidRequest(this->obd2.DISTANCE_SINCE_CODES_CLEARED);
-          break;
-        case 10:
-          this->obd2.makePidRequest(this->obd2.ABSOLUTE_BARAMETRIC_PRESSURE);
-          break;
-        case 11:
-          this->obd2.makePidRequest(this->obd2.ABSOLUTE_LOAD_VALUE);
-          break;
-        case 12:
-          this->obd2.makePidRequest(this->obd2.TIME_RUN_WITH_MIL_ON);
-          break;
-        case 13:
-          this->obd2.makePidRequest(this->obd2.TIME_SINCE_TROUBLE_CODES_CLEARED);
-          break;
-        case 14:
-          this->obd2.makePidRequest(this->obd2.ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE);
-          break;
-      }
-    }
-    
-    // log car gas level with date/time
-    void logDataPoint()
+    // log a data point with date/time
+    void logDataPoint(int logIndex, long response)
     {
-      // get requested data point that was based on current logIndex
-      const int response = this->obd2.getRequestedData();
-      
       // get the YYYYMMDDHHMMSS timestamp
-      const String dateTime = this->rtcUtils.getDateTime(this->rtc);
+      const char* dateTime = this->rtcUtils.getDateTime(this->rtc);
 
       // write log
-      if (dateTime != "" && response != -999 && this->obd2.lastRequestSucceeded()) {
-        this->writeLog(dateTime, response);
+      if (dateTime != 0) {
+        this->writeLog(logIndex, dateTime, response);
       } else {
-        if (dateTime == "") {
-          Serial.println("Unable to get date/time.");
-        }
-        if (!this->obd2.lastRequestSucceeded() || response == -999) {
-          Serial.println("Unable to get OBD-II response.");
-        }
+        Serial.println(F("Unable to get date/time."));
       }
     }
 
-    // check if OpenLog is busy, updating status as needed
-    bool isLogBusy()
+    // log each data point type separately, names stay in flash (F()) instead of taking 375 bytes of RAM
+    const __FlashStringHelper* getLogFile(int logIndex)
     {
-      if (this->logBusy == true) {
-        unsigned long logBusyCurTime = millis();
-        if (logBusyCurTime - this->logBusyStartTime >= this->logBusyPeriod) {
-          // TODO: It may help to check status of logger here (if possible), make it less time-only based
-          this->logBusy = false;
-        }
+      switch (logIndex)
+      {
+        case 0: return F("stfueltrimb1.txt");
+        case 1: return F("ltfueltrimb1.txt");
+        case 2: return F("stfueltrimb2.txt");
+        case 3: return F("ltfueltrimb2.txt");
+        case 4: return F("speed.txt");
+        case 5: return F("intaketemp.txt");
+        case 6: return F("runtimeenginestart.txt");
+        case 7: return F("distancewithmil.txt");
+        case 8: return F("warmupssincecleared.txt");
+        case 9: return F("distancesincecleared.txt");
+        case 10: return F("absbarampressure.txt");
+        case 11: return F("absload.txt");
+        case 12: return F("timerunwithmil.txt");
+        case 13: return F("timesincecleared.txt");
+        default: return F("absevapvaporpressure.txt");
       }
-      return this->logBusy;
     }
 
-    // write date/time and mileCount to the log
-    void writeLog(String dateTime, int response)
+    // write date/time and response to the log
+    void writeLog(int logIndex, String dateTime, long response)
     {
-      // give time for openLog to write file while not blocking loop()
-      this->logBusy = true; 
-      this->logBusyStartTime = millis();
-      
-      // write log
       String logLine = dateTime + "," + String(response);
-      this->openLog.append(this->logFiles[this->logIndex]);
+      this->openLog.append(this->getLogFile(logIndex));
       this->openLog.println(logLine);
       this->openLog.syncFile(); // TODO: Check if this line is really needed, seems to work when not used
-      Serial.println("logged: " + logLine);
+      Serial.print(F("logged: "));
+      Serial.println(logLine);
     }
 };
 
@@ -0,0 +1,237 @@
+/*
+ * FlightRecorder.h - Keep the last few seconds of high-rate readings in RAM, write them to OpenLog only when something goes wrong
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef FlightRecorder_h
+ #define FlightRecorder_h
+
+ #include <Arduino.h>
+ #include <SparkFun_Qwiic_OpenLog_Arduino_Library.h>
+
+ #include "RtcUtils.h" // format dates for logs
+ #include "Obd2.h" // PID constants
+ #include "SampleBus.h" // readings arrive here from Obd2
+
+ // capacity is a template parameter so the ring buffer is sized at compile time and lives in static storage
+ // Obd2 manages about 5 requests a second, so 32 entries cover roughly the 6 seconds around a trigger
+ template <byte capacity>
+ class FlightRecorder : public SampleSubscriber {
+  // one captured reading
+  struct Entry {
+    unsigned long timestamp;
+    byte pid;
+    int value; // the recorded PIDs (speed, load, fuel trims) fit 16 bits, Sample::value is long for the ones that don't
+  };
+
+  // define class variables
+  RV1805& rtc; // reference shared RTC clock instance
+  OpenLog& openLog; // reference shared OpenLog instance
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  RtcUtils rtcUtils; // create RTC utils instance
+  Entry entries[capacity]; // ring buffer, oldest entry at head once full
+  byte head = 0; // next entry to overwrite
+  byte count = 0; // entries captured so far (up to capacity)
+  const static byte postTriggerCount = capacity / 2; // keep capturing after a trigger so both sides of the event are kept
+  byte postTriggerInt = 0; // entries captured since the trigger
+  const char* triggerReason; // why the window was frozen, written to the log
+  const static int fuelTrimThreshold = 25; // |short term fuel trim| % that counts as an excursion
+  int troubleCodeCount = -1; // last confirmed DTC count from monitor status, -1 until first reading
+  const static unsigned long troubleCodePeriod = 5000; // 5 seconds between DTC count checks
+  const static unsigned long triggerCooldown = 60000; // 1 minute between triggers so a lasting fault doesn't fill the card
+  unsigned long lastTriggerTime;
+  bool hasTriggered = false;
+  bool triggerNowPending = false; // triggerNow() while a window was being written, recorded once it's done
+  const char* pendingReason;
+  const char* logFile = "flightrecorder.txt";
+  byte flushIndex = 0; // entries written so far while flushing
+  bool logBusy = false; // OpenLog will take about 15ms to write, moving along in the loop while waiting
+  const static int logBusyPeriod = 30; // 30ms
+  unsigned long logBusyStartTime;
+
+  // manage loop based on state of capture, writing one entry per loop while flushing for a "faster" app
+  const static int RECORDER_STATE_CAPTURING = 0;
+  const static int RECORDER_STATE_TRIGGERED = 1;
+  const static int RECORDER_STATE_FLUSHING = 2;
+  int recorderState = RECORDER_STATE_CAPTURING;
+
+  // public class methods
+  public:
+    // subscriptions made in setup(), the sketch sizes SampleBus from these
+    const static byte sampleSubscriptionCount = 5;
+
+    // constructor
+    FlightRecorder(RV1805 &rtc, OpenLog &openLog, SampleBus &sampleBus):
+      // member initializer list
+      rtc(rtc),
+      openLog(openLog),
+      sampleBus(sampleBus)
+    {
+    }
+
+    // class setup
+    void setup()
+    {
+      // period 0: as fast as Obd2 can get them
+      this->sampleBus.subscribe(*this, Obd2::SPEED, 0);
+      this->sampleBus.subscribe(*this, Obd2::ABSOLUTE_LOAD_VALUE, 0);
+      this->sampleBus.subscribe(*this, Obd2::SHORT_TERM_FUEL_TRIM_BANK_1, 0);
+      this->sampleBus.subscribe(*this, Obd2::SHORT_TERM_FUEL_TRIM_BANK_2, 0);
+      this->sampleBus.subscribe(*this, Obd2::CONFIRMED_TROUBLE_CODE_COUNT, troubleCodePeriod);
+    }
+
+    // class loop
+    void loop()
+    {
+      if (this->recorderState != RECORDER_STATE_FLUSHING) {
+        return;
+      }
+
+      // skip this loop immediately if OpenLog is writing the last line
+      if (this->isLogBusy()) {
+        return;
+      }
+
+      if (this->flushIndex >= this->count) {
+        // done, start a fresh window
+        this->openLog.append(this->logFile);
+        this->openLog.syncFile();
+        Serial.println(F("Flight recorder flushed."));
+        this->head = 0;
+        this->count = 0;
+        this->recorderState = RECORDER_STATE_CAPTURING;
+        if (this->triggerNowPending == true) {
+          // the window before the request was just written, record the one after it
+          this->triggerNowPending = false;
+          this->freeze(this->pendingReason);
+        }
+        return;
+      }
+      this->writeEntry(this->flushIndex++);
+    }
+
+    // capture a reading and check it for trigger conditions
+    void onSample(const Sample &sample)
+    {
+      if (sample.pid == Obd2::CONFIRMED_TROUBLE_CODE_COUNT) {
+        // a new trouble code appeared
+        if (this->troubleCodeCount >= 0 && sample.value > this->troubleCodeCount) {
+          this->trigger("trouble code");
+        }
+        this->troubleCodeCount = sample.value;
+        return;
+      }
+
+      if (this->recorderState == RECORDER_STATE_FLUSHING) {
+        // window is frozen
+        return;
+      }
+
+      Entry &entry = this->entries[this->head];
+      entry.timestamp = sample.timestamp;
+      entry.pid = sample.pid;
+      entry.value = sample.value;
+      this->head = (this->head + 1) % capacity;
+      if (this->count < capacity) {
+        this->count += 1;
+      }
+
+      if (this->recorderState == RECORDER_STATE_TRIGGERED) {
+        this->postTriggerInt += 1;
+        if (this->postTriggerInt >= postTriggerCount) {
+          this->startFlush();
+        }
+        return;
+      }
+
+      if ((sample.pid == Obd2::SHORT_TERM_FUEL_TRIM_BANK_1 || sample.pid == Obd2::SHORT_TERM_FUEL_TRIM_BANK_2)
+          && abs(sample.value) >= fuelTrimThreshold) {
+        this->trigger("fuel trim");
+      }
+    }
+
+    // freeze the window around now, at most once per cooldown so a lasting fault doesn't fill the card
+    void trigger(const char* reason)
+    {
+      if (this->recorderState != RECORDER_STATE_CAPTURING) {
+        return;
+      }
+      if (this->hasTriggered && millis() - this->lastTriggerTime < triggerCooldown) {
+        return;
+      }
+      this->freeze(reason);
+    }
+
+    // freeze and write the window right away instead of waiting for post-trigger readings, e.g. on a long button press
+    // always records, the cooldown is for automatic triggers: while a window is being written, the request waits for it
+    // to finish and then records the window after it
+    void triggerNow(const char* reason)
+    {
+      if (this->recorderState == RECORDER_STATE_FLUSHING) {
+        this->triggerNowPending = true;
+        this->pendingReason = reason;
+        return;
+      }
+      if (this->recorderState == RECORDER_STATE_CAPTURING) {
+        this->freeze(reason);
+      }
+      this->startFlush();
+    }
+
+  // private class methods
+  private:
+    // stop the window at now, post-trigger readings are still captured before it's written
+    void freeze(const char* reason)
+    {
+      this->hasTriggered = true;
+      this->lastTriggerTime = millis();
+      this->triggerReason = reason;
+      this->postTriggerInt = 0;
+      this->recorderState = RECORDER_STATE_TRIGGERED;
+      Serial.print(F("Flight recorder triggered: "));
+      Serial.println(reason);
+    }
+
+    // freeze the window and write a header for it, entries follow one per loop
+    void startFlush()
+    {
+      this->recorderState = RECORDER_STATE_FLUSHING;
+      this->flushIndex = 0;
+
+      // get the YYYYMMDDHHMMSS timestamp
+      const char* dateTime = this->rtcUtils.getDateTime(this->rtc);
+
+      this->logBusy = true;
+      this->logBusyStartTime = millis();
+      this->openLog.append(this->logFile);
+      this->openLog.println("# " + String(dateTime != 0 ? dateTime : "") + "," + String(this->triggerReason) + "," + String(this->lastTriggerTime));
+    }
+
+    // write one entry, oldest first: millis,pid,value
+    void writeEntry(byte index)
+    {
+      // once full, the oldest entry is at head
+      byte entryIndex = this->count < capacity ? index : (this->head + index) % capacity;
+      Entry &entry = this->entries[entryIndex];
+
+      // other loggers append to their own files between our lines, so select ours again every time
+      this->logBusy = true;
+      this->logBusyStartTime = millis();
+      this->openLog.append(this->logFile);
+      this->openLog.println(String(entry.timestamp) + "," + String(entry.pid) + "," + String(entry.value));
+    }
+
+    // check if OpenLog is busy, updating status as needed
+    bool isLogBusy()
+    {
+      if (this->logBusy == true) {
+        unsigned long logBusyCurTime = millis();
+        if (logBusyCurTime - this->logBusyStartTime >= logBusyPeriod) {
+          this->logBusy = false;
+        }
+      }
+      return this->logBusy;
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * MemoryBudget.h - Report the size of each subsystem object and the stack headroom left over
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef MemoryBudget_h
+ #define MemoryBudget_h
+
+ #include <Arduino.h>
+ #include <Wire.h> // for BUFFER_LENGTH
+
+ // stack headroom (bytes) left free for stack and heap, a warning is printed at boot when there is less
+ #ifndef STACK_BUDGET_BYTES
+ #define STACK_BUDGET_BYTES 512
+ #endif
+
+ // SRAM of the target: from the AVR headers (2560 on the atmega32u4, 2048 on the atmega328p), elsewhere the 32 KB of
+ // a SAMD21, the smallest 32-bit board here, define it for a board with less
+ #ifndef MCU_RAM_BYTES
+ #if defined(__AVR__)
+ #define MCU_RAM_BYTES (RAMEND - RAMSTART + 1)
+ #else
+ #define MCU_RAM_BYTES 32768
+ #endif
+ #endif
+
+ // total static RAM the sketch is allowed to take: its subsystem objects (sum of their sizeof) plus LIBRARY_STATIC_BYTES
+ // the sketch static_asserts against this, so going over budget fails the build instead of failing in the car
+ // Good to know: string literals, the core's own variables and String heap contents are not included,
+ // tools/memory-budget/check-memory-budget.sh gates on .data + .bss of the built .elf, which has all of them
+ #ifndef RAM_BUDGET_BYTES
+ #define RAM_BUDGET_BYTES (MCU_RAM_BYTES - STACK_BUDGET_BYTES)
+ #endif
+
+ // library statics no sizeof() in the sketch sees
+ #define MICRO_OLED_SCREEN_BYTES 384 // SFE_MicroOLED's screenmemory[] (64x48 pixels), a static array in the library
+ #if defined(__AVR__)
+ // Serial1's rx/tx ring buffers, Wire's rx/tx buffers and the 3 buffers of its twi.c underneath (all BUFFER_LENGTH)
+ #define LIBRARY_STATIC_BYTES (MICRO_OLED_SCREEN_BYTES + SERIAL_RX_BUFFER_SIZE + SERIAL_TX_BUFFER_SIZE + 5 * BUFFER_LENGTH)
+ #elif defined(SERIAL_BUFFER_SIZE)
+ // ArduinoCore-samd style cores: RingBuffer rx/tx for Serial1 and for Wire
+ #define LIBRARY_STATIC_BYTES (MICRO_OLED_SCREEN_BYTES + 4 * SERIAL_BUFFER_SIZE)
+ #else
+ // other cores: assume 256 byte rx/tx buffers for Serial1 and for Wire
+ #define LIBRARY_STATIC_BYTES (MICRO_OLED_SCREEN_BYTES + 4 * 256)
+ #endif
+
+ #if defined(__AVR__)
+ extern unsigned int __heap_start;
+ extern void *__brkval;
+ #else
+ extern "C" char* sbrk(int incr);
+ #endif
+
+ class MemoryBudget {
+  size_t totalBytes = 0; // running total of reported subsystem sizes
+
+  // public class methods
+  public:
+    // constructor
+    MemoryBudget()
+    {
+    }
+
+    // print the header line of the report, starting the total with the library statics
+    void begin()
+    {
+      this->totalBytes = 0;
+      Serial.println(F("RAM budget (library statics and subsystem object sizes):"));
+      this->add(F("library statics"), LIBRARY_STATIC_BYTES);
+    }
+
+    // print one subsystem object's size, e.g. add(F("OledWarpField"), sizeof(oledWarpField))
+    void add(const __FlashStringHelper* name, size_t bytes)
+    {
+      this->totalBytes += bytes;
+      Serial.print(F("  "));
+      Serial.print(name);
+      Serial.print(F(": "));
+      Serial.println(bytes);
+    }
+
+    // print totals and the current stack headroom
+    void end()
+    {
+      Serial.print(F("  total: "));
+      Serial.print(this->totalBytes);
+      Serial.print(F(" / "));
+      Serial.println(RAM_BUDGET_BYTES);
+
+      const int freeStack = this->getFreeStack();
+      Serial.print(F("  free stack: "));
+      Serial.println(freeStack);
+      if (freeStack < STACK_BUDGET_BYTES) {
+        Serial.println(F("WARNING: stack headroom is below STACK_BUDGET_BYTES."));
+      }
+    }
+
+    // bytes between the top of the heap and the current stack pointer
+    // many thanks: https://learn.adafruit.com/memories-of-an-arduino/measuring-free-memory
+    int getFreeStack()
+    {
+      char top;
+      #if defined(__AVR__)
+      return &top - (__brkval == 0 ? (char*) &__heap_start : (char*) __brkval);
+      #else
+      return &top - reinterpret_cast<char*>(sbrk(0));
+      #endif
+    }
+};
+
+#endif
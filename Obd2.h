@@ -8,7 +8,11 @@
 
  #include <Arduino.h>
 
+ #include "SampleBus.h" // decoded readings are published here, and requests are scheduled from its subscriptions
+
  class Obd2 {
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  Stream& port; // OBD-II UART at 9600 baud, begun by the caller: Serial1 in the car, a scripted stream in benchmarks
   
   // public class methods
   public:
@@ -19,46 +23,58 @@
     unsigned long obdBusyStartTime;
     unsigned long obdBusyCurTime;
 
-    // Service/PID constants for use in requests
-    const String SHORT_TERM_FUEL_TRIM_BANK_1 = "0106";
-    const String LONG_TERM_FUEL_TRIM_BANK_1 = "0107";
-    const String SHORT_TERM_FUEL_TRIM_BANK_2 = "0108";
-    const String LONG_TERM_FUEL_TRIM_BANK_2 = "0109";
-    const String SPEED = "010D";
-    const String AIR_INTAKE_TEMP = "010F";
-    const String RUN_TIME_SINCE_ENGINE_START = "011F";
-    const String DISTANCE_WITH_MIL_ON = "0121";
-    const String WARMUPS_SINCE_CODES_CLEARED = "0130";
-    const String DISTANCE_SINCE_CODES_CLEARED = "0131";
-    const String ABSOLUTE_BARAMETRIC_PRESSURE = "0133";
-    const String ABSOLUTE_LOAD_VALUE = "0143";
-    const String TIME_RUN_WITH_MIL_ON = "014D";
-    const String TIME_SINCE_TROUBLE_CODES_CLEARED = "014E";
-    const String ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE = "0153";
-    const String CLEAR_TROUBLE_CODES = "0400"; // WARNING: USE AT YOUR OWN RISK: ALSO CLEARS TEST DATA USED BY MECHANICS AND EMISSIONS TESTS
-    String lastRequestPid;
+    // Mode 01 (current data) PID constants for use in requests
+    const static byte CONFIRMED_TROUBLE_CODE_COUNT = 0x01; // monitor status since codes cleared, decoded to its DTC count
+    const static byte SHORT_TERM_FUEL_TRIM_BANK_1 = 0x06;
+    const static byte LONG_TERM_FUEL_TRIM_BANK_1 = 0x07;
+    const static byte SHORT_TERM_FUEL_TRIM_BANK_2 = 0x08;
+    const static byte LONG_TERM_FUEL_TRIM_BANK_2 = 0x09;
+    const static byte ENGINE_RPM = 0x0C;
+    const static byte SPEED = 0x0D;
+    const static byte AIR_INTAKE_TEMP = 0x0F;
+    const static byte RUN_TIME_SINCE_ENGINE_START = 0x1F;
+    const static byte DISTANCE_WITH_MIL_ON = 0x21;
+    const static byte WARMUPS_SINCE_CODES_CLEARED = 0x30;
+    const static byte DISTANCE_SINCE_CODES_CLEARED = 0x31;
+    const static byte ABSOLUTE_BARAMETRIC_PRESSURE = 0x33;
+    const static byte ABSOLUTE_LOAD_VALUE = 0x43;
+    const static byte TIME_RUN_WITH_MIL_ON = 0x4D;
+    const static byte TIME_SINCE_TROUBLE_CODES_CLEARED = 0x4E;
+    const static byte ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE = 0x53;
+
+    // not a real PID: adapter battery voltage (ATRV), decoded to tenths of a volt, published like any other reading
+    const static byte BATTERY_VOLTAGE = 0xFE;
+
+    // other service commands
+    const char* CLEAR_TROUBLE_CODES = "0400"; // WARNING: USE AT YOUR OWN RISK: ALSO CLEARS TEST DATA USED BY MECHANICS AND EMISSIONS TESTS
+    byte lastRequestPid = SampleBus::NO_PID; // NO_PID when the last request was not a mode 01 PID
     bool lastRequestSuccess;
+    unsigned long lastResponseTime = 0; // millis() of the last decoded reading from the car (not the adapter), used to detect engine off
+    bool polling = true; // request PIDs subscribers need, turned off in idle mode to poll a slow heartbeat instead
+    bool monitoring = false; // CanMonitor owns the UART while the adapter is in CAN monitor mode, no requests at all
     
     // constructor
-    Obd2() 
+    Obd2(SampleBus &sampleBus, Stream &port):
+      // member initializer list
+      sampleBus(sampleBus),
+      port(port)
     {
     }
 
     // class setup
     void setup()
     {
-      Serial1.begin(9600);
-      Serial1.flush();
+      this->port.flush();
       // add a delay to give time for car wake up
       delay(2000);
       // reset the OBD-II-UART
-      Serial1.println("ATZ");
+      this->port.println("ATZ");
       // give time to reset
       delay(2000);
       this->getObd2Response();
       // don't echo sent commands when getting responses
-      Serial1.flush();
-      Serial1.println("ATE0");
+      this->port.flush();
+      this->port.println("ATE0");
       delay(200);
       this->getObd2Response();
     }
@@ -71,7 +87,19 @@
         if (this->obdBusyCurTime - this->obdBusyStartTime >= obdBusyPeriod) {
           // last OBD-II UART request is complete*
           this->obdBusy = false;
+          this->publishRequestedData();
         }
+        return;
+      }
+
+      if (this->polling == false || this->monitoring == true) {
+        return;
+      }
+
+      // request whichever PID subscribers need next, one request serves every subscriber of that PID
+      byte pid = this->sampleBus.getNextDuePid(millis());
+      if (pid != SampleBus::NO_PID) {
+        this->makePidRequest(pid);
       }
     }
 
@@ -80,22 +108,53 @@
       return this->obdBusy;
     }
 
-    // query OBD-II UART with four character PID
-    // Example: 014E
-    // 01 = mode 1 (current data)
-    // 4E = PID for mode 1 -> get current time since trouble codes cleared
-    void makePidRequest(String pid)
+    // turn scheduled requests from SampleBus on/off, requests made with makePidRequest() still go through
+    void setPolling(bool polling)
     {
-      // let other functionality know that OBD-II is busy for a few ms
-      this->obdBusy = true;
-      this->obdBusyStartTime = millis();
+      this->polling = polling;
+    }
+
+    // hand the UART over to CanMonitor (true) or take it back (false)
+    void setMonitoring(bool monitoring)
+    {
+      this->monitoring = monitoring;
+    }
+
+    // millis() of the last decoded reading from the car
+    unsigned long getLastResponseTime()
+    {
+      return this->lastResponseTime;
+    }
+
+    // the car is talking even though we didn't ask, e.g. CAN frames seen by CanMonitor
+    void markCarActivity()
+    {
+      this->lastResponseTime = millis();
+    }
+
+    // query OBD-II UART with a mode 01 PID
+    // Example: 0x4E
+    // sent as 014E: 01 = mode 1 (current data), 4E = PID for mode 1 -> get current time since trouble codes cleared
+    void makePidRequest(byte pid)
+    {
+      if (pid == BATTERY_VOLTAGE) {
+        this->sendRequest("ATRV");
+      } else {
+        char command[5];
+        sprintf(command, "01%02X", pid);
+        this->sendRequest(command);
+      }
 
       // remember request PID for when request is finished
       this->lastRequestPid = pid;
-      
-      Serial1.flush();
-      Serial1.println(pid);
-      // a 200ms or so delay is required here at 9600 baud before requesting result of the request, accomplished here without delay() (obdBusy)
+    }
+
+    // query OBD-II UART with a raw four character service command whose response isn't decoded
+    // Example: 0400 (clear trouble codes)
+    void makePidRequest(const char* command)
+    {
+      this->sendRequest(command);
+      this->lastRequestPid = SampleBus::NO_PID;
     }
 
     // Did the last request succeed?
@@ -110,76 +169,86 @@
     // Toyota tested here doesn't produce data for the following (among others e.g. you usually wouldn't get NOx sensor corrected data from a Camry...):
     // 012F: fuel tank level input
     // 01A6: odometer (this one is very new I think)
-    int getRequestedData()
+    long getRequestedData()
     {
-      // read response from Serial1
+      // read response from the OBD-II UART
       this->getObd2Response();
 
+      // the adapter answers "NO DATA" and the like when the car doesn't, mode 01 replies start with 41
+      if (this->lastRequestPid != BATTERY_VOLTAGE && strncmp(rxData, "41", 2) != 0) {
+        this->lastRequestSuccess = false;
+      }
+
       // if a success, return calculated results
       if (this->lastRequestSuccess) {
-        if (this->lastRequestPid == SHORT_TERM_FUEL_TRIM_BANK_1) {
-          // get short term fuel trim, bank 1: -100 (reduce fuel, too rich) - 99.2 (add fuel, too lean)
-          // PID 0106
-          return (100 / 128 * strtol(&rxData[6], 0, 16)) - 100;
-        } else if (this->lastRequestPid == LONG_TERM_FUEL_TRIM_BANK_1) {
-          // get long term fuel trim, bank 1: -100 (reduce fuel, too rich) - 99.2 (add fuel, too lean)
-          // PID 0107
-          return (100 / 128 * strtol(&rxData[6], 0, 16)) - 100;
-        } else if (this->lastRequestPid == SHORT_TERM_FUEL_TRIM_BANK_2) {
-          // get short term fuel trim, bank 2: -100 (reduce fuel, too rich) - 99.2 (add fuel, too lean)
-          // PID 0108
-          return (100 / 128 * strtol(&rxData[6], 0, 16)) - 100;
-        } else if (this->lastRequestPid == LONG_TERM_FUEL_TRIM_BANK_2) {
-          // get long term fuel trim, bank 2: -100 (reduce fuel, too rich) - 99.2 (add fuel, too lean)
-          // PID 0109
-          return (100 / 128 * strtol(&rxData[6], 0, 16)) - 100;
-        } else if (this->lastRequestPid == SPEED) {
-          // get speed: 0 - 255 km/h
-          // PID 010D
-          return strtol(&rxData[6], 0, 16);
-        } else if (this->lastRequestPid == AIR_INTAKE_TEMP) {
-          // get intake air temperature: -40 - 215 °C
-          // PID 010F
-          return strtol(&rxData[6], 0, 16) - 40;
-        } else if (this->lastRequestPid == RUN_TIME_SINCE_ENGINE_START) {
-          // get run time since engine start: 0 - 65,535 seconds
-          // PID 011F
-          return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
-        } else if (DISTANCE_WITH_MIL_ON) {
-          // get distance traveled with malfunction indicator lamp (MIL) on: 0 - 65,535 km
-          // PID 0121
-          return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
-        } else if (this->lastRequestPid == WARMUPS_SINCE_CODES_CLEARED) {
-          // get warm-ups since codes cleared: 0 - 256 count
-          // PID 0130
-          return strtol(&rxData[6], 0, 16);
-        } else if (this->lastRequestPid == DISTANCE_SINCE_CODES_CLEARED) {
-          // get distance traveled since codes cleared: 0 - 65,535 km
-          // PID 0131
-          return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
-        } else if (this->lastRequestPid == ABSOLUTE_BARAMETRIC_PRESSURE) {
-          // get absolute barometric pressure: 0 - 256 kPa
-          // PID 0133
-          return strtol(&rxData[6], 0, 16);
-        } else if (this->lastRequestPid == ABSOLUTE_LOAD_VALUE) {
-          // get absolute load value: 0 - 25,700 %
-          // PID 0143
-          return 100 / 255 * ((strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16));
-        } else if (this->lastRequestPid == TIME_RUN_WITH_MIL_ON) {
-          // get time run with MIL on: 0 - 65,535 minutes
-          // PID 014D
-          return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
-        } else if (this->lastRequestPid == TIME_SINCE_TROUBLE_CODES_CLEARED) {
-          // get time since trouble codes cleared: 0 - 65,535 minutes
-          // PID 014E
-          return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
-        } else if (this->lastRequestPid == ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE) {
-          // get time since trouble codes cleared: 0 - 65,535 minutes
-          // PID 014E
-          return ((strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16)) / 200;
-        } else {
-          // no match
-          return -999;
+        switch (this->lastRequestPid)
+        {
+          case BATTERY_VOLTAGE:
+            // get adapter battery voltage: e.g. 12.6V -> 126
+            // ATRV
+            return round(strtod(rxData, 0) * 10);
+          case CONFIRMED_TROUBLE_CODE_COUNT:
+            // get number of confirmed trouble codes: 0 - 127 count (bit 7 is the MIL, masked off)
+            // PID 0101
+            return strtol(&rxData[6], 0, 16) & 0x7F;
+          case SHORT_TERM_FUEL_TRIM_BANK_1: // 0106
+          case LONG_TERM_FUEL_TRIM_BANK_1: // 0107
+          case SHORT_TERM_FUEL_TRIM_BANK_2: // 0108
+          case LONG_TERM_FUEL_TRIM_BANK_2: // 0109
+            // get short/long term fuel trim: -100 (reduce fuel, too rich) - 99.2 (add fuel, too lean)
+            // (multiply before dividing, 100 / 128 is 0 in integer math)
+            return (strtol(&rxData[6], 0, 16) * 100 / 128) - 100;
+          case ENGINE_RPM:
+            // get engine speed: 0 - 16,383.75 rpm
+            // PID 010C
+            return ((strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16)) / 4;
+          case SPEED:
+            // get speed: 0 - 255 km/h
+            // PID 010D
+            return strtol(&rxData[6], 0, 16);
+          case AIR_INTAKE_TEMP:
+            // get intake air temperature: -40 - 215 °C
+            // PID 010F
+            return strtol(&rxData[6], 0, 16) - 40;
+          case RUN_TIME_SINCE_ENGINE_START:
+            // get run time since engine start: 0 - 65,535 seconds
+            // PID 011F
+            return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
+          case DISTANCE_WITH_MIL_ON:
+            // get distance traveled with malfunction indicator lamp (MIL) on: 0 - 65,535 km
+            // PID 0121
+            return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
+          case WARMUPS_SINCE_CODES_CLEARED:
+            // get warm-ups since codes cleared: 0 - 256 count
+            // PID 0130
+            return strtol(&rxData[6], 0, 16);
+          case DISTANCE_SINCE_CODES_CLEARED:
+            // get distance traveled since codes cleared: 0 - 65,535 km
+            // PID 0131
+            return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
+          case ABSOLUTE_BARAMETRIC_PRESSURE:
+            // get absolute barometric pressure: 0 - 256 kPa
+            // PID 0133
+            return strtol(&rxData[6], 0, 16);
+          case ABSOLUTE_LOAD_VALUE:
+            // get absolute load value: 0 - 25,700 %
+            // PID 0143
+            return ((strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16)) * 100 / 255;
+          case TIME_RUN_WITH_MIL_ON:
+            // get time run with MIL on: 0 - 65,535 minutes
+            // PID 014D
+            return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
+          case TIME_SINCE_TROUBLE_CODES_CLEARED:
+            // get time since trouble codes cleared: 0 - 65,535 minutes
+            // PID 014E
+            return (strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16);
+          case ABSOLUTE_EVAP_SYSTEM_VAPOR_PRESSURE:
+            // get absolute evap system vapor pressure
+            // PID 0153
+            return ((strtol(&rxData[6],0,16) * 256) + strtol(&rxData[9],0,16)) / 200;
+          default:
+            // no match
+            return -999;
         }
       } else {
         // use -999 as "failed data request error" for now
@@ -188,6 +257,39 @@
     }
 
   private:
+    // send a four character request, a 200ms or so delay is required at 9600 baud before requesting the result (obdBusy)
+    void sendRequest(const char* command)
+    {
+      // let other functionality know that OBD-II is busy for a few ms
+      this->obdBusy = true;
+      this->obdBusyStartTime = millis();
+
+      this->port.flush();
+      this->port.println(command);
+    }
+
+    // decode the finished request and publish it once for every subscriber
+    void publishRequestedData()
+    {
+      const long value = this->getRequestedData();
+      if (this->lastRequestPid == SampleBus::NO_PID) {
+        return;
+      }
+      if (this->lastRequestSuccess && value != -999) {
+        Sample sample;
+        sample.pid = this->lastRequestPid;
+        sample.timestamp = millis();
+        sample.value = value;
+        if (sample.pid != BATTERY_VOLTAGE) {
+          this->lastResponseTime = sample.timestamp;
+        }
+        this->sampleBus.publish(sample);
+      } else {
+        this->sampleBus.skip(this->lastRequestPid, millis());
+        Serial.println(F("Unable to get OBD-II response."));
+      }
+    }
+
     // get response from OBD-II UART
     // many thanks: https://forum.sparkfun.com/viewtopic.php?t=35507
     void getObd2Response()
@@ -195,14 +297,14 @@
       char c; // currently read character
 
       // don't get data if unavailable
-      if (Serial1.available() <= 0) {
+      if (this->port.available() <= 0) {
         this->lastRequestSuccess = false;
         return;
       }
 
       // do get data if available
       do {
-        c = Serial1.read();
+        c = this->port.read();
         
         // cut off the response if it is too big for some reason
         if (rxIndex >= 19) {
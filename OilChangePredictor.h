@@ -0,0 +1,101 @@
+/*
+ * OilChangePredictor.h - Predict hours until the next oil change from distance driven since codes were cleared
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef OilChangePredictor_h
+ #define OilChangePredictor_h
+
+ #include <Arduino.h>
+
+ #include "Obd2.h" // PID constants
+ #include "SampleBus.h" // distance readings arrive here from Obd2
+
+ class OilChangePredictor : public SampleSubscriber {
+  // define class variables
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  const static unsigned long samplePeriod = 600000; // 10 minutes, distance changes slowly
+  const static long oilChangeIntervalKm = 8046; // 5,000 miles, assumes codes are cleared at each oil change
+  bool hasFirstSample = false; // need two readings before a rate can be estimated
+  unsigned long firstSampleTime; // millis() of first distance reading since boot or codes cleared
+  long firstSampleKm; // first distance reading since boot or codes cleared
+  long lastSampleKm; // a smaller reading means codes were cleared (oil change)
+  bool hasRate = false;
+  float kmPerHour; // last estimated rate, carried across a codes clear until a new one is available
+  bool hasPrediction = false;
+  float nextOilChangeHours;
+
+  // public class methods
+  public:
+    // subscriptions made in setup(), the sketch sizes SampleBus from these
+    const static byte sampleSubscriptionCount = 1;
+
+    // constructor
+    OilChangePredictor(SampleBus &sampleBus): sampleBus(sampleBus)
+    {
+    }
+
+    // class setup
+    void setup()
+    {
+      this->sampleBus.subscribe(*this, Obd2::DISTANCE_SINCE_CODES_CLEARED, samplePeriod);
+    }
+
+    // update prediction from a distance since codes cleared reading
+    // Good to know: the rate is km per hour of device uptime (millis()), parked time included while the device stays
+    // powered, so predictions are in wall clock hours, and rebooting starts the rate over
+    void onSample(const Sample &sample)
+    {
+      if (this->hasFirstSample == true && sample.value < this->lastSampleKm) {
+        // codes were cleared, e.g. with a long button press at an oil change: start over from here
+        this->hasFirstSample = false;
+      }
+      this->lastSampleKm = sample.value;
+
+      if (this->hasFirstSample == false) {
+        this->hasFirstSample = true;
+        this->firstSampleTime = sample.timestamp;
+        this->firstSampleKm = sample.value;
+        // keep the screen current with the last known rate until there is a new one
+        this->updatePrediction(sample.value);
+        return;
+      }
+
+      // km driven per hour of (wall clock) time since we started watching
+      const float hours = (sample.timestamp - this->firstSampleTime) / 3600000.0;
+      const long km = sample.value - this->firstSampleKm;
+      if (hours <= 0 || km <= 0) {
+        return;
+      }
+      this->kmPerHour = km / hours;
+      this->hasRate = true;
+      this->updatePrediction(sample.value);
+    }
+
+    // is there enough data for a prediction yet?
+    bool getHasPrediction()
+    {
+      return this->hasPrediction;
+    }
+
+    // predicted hours until the next oil change
+    float getNextOilChangeHours()
+    {
+      return this->nextOilChangeHours;
+    }
+
+  // private class methods
+  private:
+    // hours left at the current rate for a distance since codes cleared reading
+    void updatePrediction(long km)
+    {
+      if (this->hasRate == false) {
+        return;
+      }
+      const long kmLeft = oilChangeIntervalKm - km;
+      this->nextOilChangeHours = kmLeft > 0 ? kmLeft / this->kmPerHour : 0;
+      this->hasPrediction = true;
+    }
+};
+
+#endif
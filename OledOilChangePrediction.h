@@ -9,11 +9,18 @@
  #include <Arduino.h>
  #include <SFE_MicroOLED.h>  // Include the SFE_MicroOLED library
 
+ #include "OledTextTile.h" // text rasterised once, blitted each frame
+
  class OledOilChangePrediction {
   // define class variables
   MicroOLED& oled; // the canvas we'll paint on ("&" for: "a reference member" that is shared between classes)
   byte animate; // to animate or not to animate
   float nextOilChangeHours; // next oil change prediction
+  OledTextTile<48, 1> nextOilTile; // "Next Oil", rendered once in setup()
+  OledTextTile<48, 1> changeTile; // "Change:", rendered once in setup()
+  OledTextTile<64, 1> predictionTile; // e.g. "23 Days", rendered again only when it changes, full LCD width for "1234 Days"
+  long shownValue = -1; // rounded days/hours in predictionTile, -1 until first render
+  bool shownInDays; // unit in predictionTile
 
   // public class methods
   public:
@@ -37,7 +44,8 @@
     // class setup
     void setup()
     {
-      //
+      this->nextOilTile.render(this->oled, 0, "Next Oil");
+      this->changeTile.render(this->oled, 0, "Change:");
     }
 
     // class loop
@@ -53,36 +61,19 @@
   private:
     void animateOilChangePrediction()
     {
-      this->oled.setFontType(0);
-      this->oled.setCursor(11, 9);
-      this->oled.print("Next Oil");
-      this->oled.setCursor(14, 18);
-      this->oled.print("Change:");
-    
-      if (this->nextOilChangeHours > 72) {
-        // show in days
-        float days = this->nextOilChangeHours / 24.0;
-        String dayString = String(round(days));
-        // attempt to center line of text
-        if (days >= 100) {
-          this->oled.setCursor(10, 32);
-        } else {
-          this->oled.setCursor(13, 32);
-        }
-        this->oled.setFontType(0);
-        this->oled.print(dayString + " Days");
-      } else {
-        // show in hours
-        String hourString = String(round(this->nextOilChangeHours));
-        // attempt to center line of text
-        if (this->nextOilChangeHours >= 20) {
-          this->oled.setCursor(10, 32);
-        } else {
-          this->oled.setCursor(13, 32);
-        }
-        this->oled.setFontType(0);
-        this->oled.print(hourString + " Hours");
+      this->nextOilTile.blitCentered(this->oled, 9);
+      this->changeTile.blitCentered(this->oled, 18);
+
+      // show in days when far out, hours when close
+      const bool inDays = this->nextOilChangeHours > 72;
+      const long value = round(inDays ? this->nextOilChangeHours / 24.0 : this->nextOilChangeHours);
+      if (value != this->shownValue || inDays != this->shownInDays) {
+        this->shownValue = value;
+        this->shownInDays = inDays;
+        String predictionString = String(value) + (inDays ? " Days" : " Hours");
+        this->predictionTile.render(this->oled, 0, predictionString.c_str());
       }
+      this->predictionTile.blitCentered(this->oled, 32);
     }
 };
 
@@ -0,0 +1,106 @@
+/*
+ * OledTextTile.h - Text rasterised once into a bitmap tile, then blitted into the SparkFun Micro OLED Qwiic buffer each frame
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef OledTextTile_h
+ #define OledTextTile_h
+
+ #include <Arduino.h>
+ #include <SFE_MicroOLED.h>  // Include the SFE_MicroOLED library
+
+ // width (pixels) and pages (8 pixel rows each) are template parameters so tiles are sized at compile time
+ // the OLED buffer is laid out the same way: one byte per column per page, bit n = row n of the page
+ template <byte width, byte pages>
+ class OledTextTile {
+  // define class variables
+  byte tile[pages * width]; // rasterised text, page by page
+  byte textWidth = 0; // width of the rendered text in pixels, from glyph metrics
+  byte textHeight = 0; // height of the rendered text in pixels, from glyph metrics
+
+  // public class methods
+  public:
+    // constructor
+    OledTextTile()
+    {
+    }
+
+    // rasterise text with the library's own glyph renderer, call on state entry or when the text changes
+    // draws into the top pages of the OLED buffer and puts back what was there, so it's safe mid-frame
+    void render(MicroOLED &oled, byte fontType, const char* text)
+    {
+      byte* buffer = oled.getScreenBuffer();
+      const byte lcdWidth = oled.getLCDWidth();
+      byte saved[pages * width];
+
+      // move the top-left corner of the buffer out of the way
+      for (byte page=0; page<pages; page++)
+      {
+        memcpy(&saved[page * width], &buffer[page * lcdWidth], width);
+        memset(&buffer[page * lcdWidth], 0, width);
+      }
+
+      oled.setFontType(fontType);
+      oled.setCursor(0, 0);
+      oled.print(text);
+
+      // the library advances the cursor by fontWidth + 1 per character
+      const int fullWidth = strlen(text) * (oled.getFontWidth() + 1) - 1;
+      this->textWidth = constrain(fullWidth, 0, width);
+      this->textHeight = constrain(oled.getFontHeight(), 0, pages * 8);
+
+      // keep the tile, put the buffer back
+      for (byte page=0; page<pages; page++)
+      {
+        memcpy(&this->tile[page * width], &buffer[page * lcdWidth], width);
+        memcpy(&buffer[page * lcdWidth], &saved[page * width], width);
+      }
+    }
+
+    // OR the tile into the OLED buffer with its top-left corner at x, y
+    void blit(MicroOLED &oled, byte x, byte y)
+    {
+      byte* buffer = oled.getScreenBuffer();
+      const byte lcdWidth = oled.getLCDWidth();
+      const byte lcdPages = oled.getLCDHeight() / 8;
+      const byte shift = y % 8;
+      const byte columns = min(this->textWidth, (byte) (lcdWidth - x));
+
+      for (byte page=0; page<pages; page++)
+      {
+        const byte destPage = y / 8 + page;
+        for (byte column=0; column<columns; column++)
+        {
+          const byte bits = this->tile[page * width + column];
+          if (bits == 0) {
+            continue;
+          }
+          // a tile page straddles two buffer pages unless y is a multiple of 8
+          if (destPage < lcdPages) {
+            buffer[destPage * lcdWidth + x + column] |= bits << shift;
+          }
+          if (shift > 0 && destPage + 1 < lcdPages) {
+            buffer[(destPage + 1) * lcdWidth + x + column] |= bits >> (8 - shift);
+          }
+        }
+      }
+    }
+
+    // blit horizontally centered on the screen
+    void blitCentered(MicroOLED &oled, byte y)
+    {
+      this->blit(oled, (oled.getLCDWidth() - this->textWidth) / 2, y);
+    }
+
+    byte getTextWidth()
+    {
+      return this->textWidth;
+    }
+
+    byte getTextHeight()
+    {
+      return this->textHeight;
+    }
+};
+
+#endif
@@ -9,17 +9,23 @@
  #include <Arduino.h>
  #include <SFE_MicroOLED.h>  // Include the SFE_MicroOLED library
 
+ #include "OledTextTile.h" // text rasterised once, blitted each frame
+
  class OledTroubleCodes {
   // define class variables
   MicroOLED& oled; // the canvas we'll paint on ("&" for: "a reference member" that is shared between classes)
   byte animate; // to animate or not to animate
-  String troubleCodes[10]; // make room for up to 10 trouble codes for now
+  const static byte troubleCodeCount = 10; // make room for up to 10 trouble codes for now
+  String* troubleCodes = 0; // the caller's troubleCodeCount long array, shown in place instead of copied
   int troubleCodeFrames = 100; // how many frames to show each trouble code
   int troubleCodeFramesInt = 0; // how many frames code has been shown so far
   int troubleCodeIndex = 0; // the current trouble code index to be shown
   int borderBlinkFrames = 10; // how many frames to show/hide blinking border
   int borderBlinkFramesInt = 0; // how many frames shown/hidden so far
   bool borderBlinkToggle = true; // true: show border, false: hide border
+  OledTextTile<44, 2> uhOhTile; // "UH OH", rendered once in setup(), 5 characters of font 1 are 44 pixels wide
+  OledTextTile<44, 2> troubleCodeTile; // current trouble code, rendered again only when the index changes
+  int shownTroubleCodeIndex = -1; // trouble code index in troubleCodeTile, -1 to force a render
 
   // public class methods
   public:
@@ -34,27 +40,26 @@
       this->animate = animate;
     }
 
-    // set trouble codes to show
-    void setTroubleCodes(String codes[10])
+    // set trouble codes to show, the array has to outlive this class (e.g. a global in the sketch)
+    void setTroubleCodes(String codes[troubleCodeCount])
     {
-      // It seems to take effort to assign an array to an array in C++, pre C++11?
-      // Is there a better way to do this?
-      for (int i=0; i<10; i++)
-      {
-        this->troubleCodes[i] = codes[i];
-      } 
+      this->troubleCodes = codes;
+      this->troubleCodeIndex = 0;
+      this->shownTroubleCodeIndex = -1;
     }
 
     // clear trouble codes
     void resetTroubleCodes()
     {
-      this->troubleCodes[10];
+      this->troubleCodes = 0;
+      this->troubleCodeIndex = 0;
+      this->shownTroubleCodeIndex = -1;
     }
 
     // class setup
     void setup()
     {
-      //
+      this->uhOhTile.render(this->oled, 1, "UH OH");
     }
 
     // class loop
@@ -86,17 +91,17 @@
       }
   
       // show trouble codes
-      this->oled.setFontType(1);
-      this->oled.setCursor(11, 9);
-      this->oled.print("UH OH");
-      this->oled.setFontType(1);
-      this->oled.setCursor(11, 24);
-      this->oled.print(this->troubleCodes[this->troubleCodeIndex]);
+      if (this->troubleCodeIndex != this->shownTroubleCodeIndex) {
+        this->shownTroubleCodeIndex = this->troubleCodeIndex;
+        this->troubleCodeTile.render(this->oled, 1, this->troubleCodes != 0 ? this->troubleCodes[this->troubleCodeIndex].c_str() : "");
+      }
+      this->uhOhTile.blitCentered(this->oled, 9);
+      this->troubleCodeTile.blitCentered(this->oled, 24);
       this->troubleCodeFramesInt += 1;
       if (this->troubleCodeFramesInt > this->troubleCodeFrames) {
         this->troubleCodeFramesInt = 0;
         this->troubleCodeIndex += 1;
-        if (this->troubleCodes[this->troubleCodeIndex] == NULL) {
+        if (this->troubleCodeIndex >= troubleCodeCount || this->troubleCodes == 0 || this->troubleCodes[this->troubleCodeIndex] == NULL) {
           this->troubleCodeIndex = 0;
         }
       }
@@ -9,11 +9,13 @@
  #include <Arduino.h>
  #include <SFE_MicroOLED.h>  // Include the SFE_MicroOLED library
 
+ // starCount is a template parameter so the star array is sized at compile time and lives in static storage
+ template <byte starCount>
  class OledWarpField {
   // define class variables
   MicroOLED& oled; // the canvas we'll paint on ("&" for: "a reference member" that is shared between classes)
-  byte starCount; // star count set in constructor
-  float *stars; // this will be an array
+  // We're using one memory block for n sets of x,y,z values instead of heavier multidimensional array.
+  float stars[starCount * 3];
   float screenWidthDivBy2; // oled screen width divided by two
   float screenHeightDivBy2; // oled screen height divided by two
   byte animate; // to animate or not to animate
@@ -21,15 +23,11 @@
   // public class methods
   public:
     // constructor
-    OledWarpField(MicroOLED &oled, byte starCount):
+    OledWarpField(MicroOLED &oled):
       // member initializer list
       oled(oled),
-      starCount(starCount),
-      animate(animate)
+      animate(0)
     {
-      // We're allocating one memory block for n sets of x,y,z values instead of heavier multidimensional array.
-      // See: https://stackoverflow.com/questions/936687/how-do-i-declare-a-2d-array-in-c-using-new
-      this->stars = new float[starCount * 3];
       this->screenWidthDivBy2 = oled.getLCDWidth() / 2;
       this->screenHeightDivBy2 = oled.getLCDHeight() / 2;
     }
@@ -61,7 +59,7 @@
     // initialize the warp field with starting star positions
     void createWarpField()
     {
-      for (int i=0; i<this->starCount; i++)
+      for (int i=0; i<starCount; i++)
       {
         this->setStarPos(this->stars[i*3+0], this->stars[i*3+1], this->stars[i*3+2]);
       }
@@ -80,7 +78,7 @@
     // animate the warp field and show it on the oled, run in loop()
     void animateWarpField()
     {
-      for (byte i=0; i<this->starCount; i++)
+      for (byte i=0; i<starCount; i++)
       {
         this->stars[i*3+2] += 0.001;
         this->stars[i*3+0] = this->stars[i*3+0] + (this->stars[i*3+0] * this->stars[i*3+2]);
@@ -0,0 +1,208 @@
+/*
+ * PowerManager.h - Engine-off idle mode: stop rendering, poll heartbeats and sleep the MCU in between
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef PowerManager_h
+ #define PowerManager_h
+
+ #include <Arduino.h>
+ #if defined(__AVR__)
+ #include <avr/sleep.h>
+ #endif
+
+ #include "Obd2.h" // PID constants, heartbeat requests and last response time
+ #include "SampleBus.h" // battery voltage readings arrive here from Obd2
+
+ class PowerManager : public SampleSubscriber {
+  // define class variables
+  Obd2& obd2; // reference shared Obd2 instance
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  const static unsigned long voltagePeriod = 30000; // 30 seconds between battery voltage checks while active
+  const static int engineRunningVolts = 132; // 13.2V: at or above, the alternator is charging and the engine is running
+  const static unsigned long idleTimeout = 60000; // 1 minute without an answer from the car: engine is off
+  const static unsigned long lowVoltageIdleTimeout = 10000; // 10 seconds is enough when voltage also says engine is off
+  // idle heartbeats: the adapter answers ATRV itself without the car bus, so voltage is cheap to check often and catches
+  // the alternator kicking in within about voltageHeartbeatPeriod + 200ms request + a second of alternator ramp (~3 s)
+  // after engine start. Run time needs the car bus, it's the slow fallback for cars whose idle voltage stays below
+  // engineRunningVolts (smart alternators), waking within runTimeHeartbeatPeriod + 200ms (~15 s) there
+  const static unsigned long voltageHeartbeatPeriod = 1500; // 1.5 seconds between battery voltage checks while idle
+  const static unsigned long runTimeHeartbeatPeriod = 15000; // 15 seconds between engine run time checks while idle
+  const static unsigned long reportPeriod = 300000; // 5 minutes between mode/duty cycle reports
+  int lastVolts = 0; // last battery voltage reading (tenths of a volt), 0 until first reading
+  unsigned long lastVoltageHeartbeatTime;
+  unsigned long lastRunTimeHeartbeatTime;
+  unsigned long idleResponseTime; // Obd2's last response time when idle mode was entered, any newer response means the car is awake
+  unsigned long lastReportTime;
+
+  // time accounting for reports
+  unsigned long modeStartTime; // millis() when the current mode was entered
+  unsigned long activeTime = 0; // ms spent active before the current mode
+  unsigned long idleTime = 0; // ms spent idle before the current mode
+  unsigned long sleepTime = 0; // ms the MCU spent asleep while idle
+
+  // manage loop based on engine state
+  const static int POWER_STATE_ACTIVE = 0;
+  const static int POWER_STATE_IDLE = 1;
+  int powerState = POWER_STATE_ACTIVE;
+
+  // set from the button interrupt, read in loop()
+  static volatile bool& wakeRequested()
+  {
+    static volatile bool flag = false;
+    return flag;
+  }
+
+  static void onWakeInterrupt()
+  {
+    wakeRequested() = true;
+  }
+
+  // public class methods
+  public:
+    // subscriptions made in setup(), the sketch sizes SampleBus from these
+    const static byte sampleSubscriptionCount = 1;
+
+    // constructor
+    PowerManager(Obd2 &obd2, SampleBus &sampleBus):
+      // member initializer list
+      obd2(obd2),
+      sampleBus(sampleBus)
+    {
+    }
+
+    // class setup, wakePin is wired to the Qwiic Button INT pin (active low)
+    void setup(byte wakePin)
+    {
+      this->sampleBus.subscribe(*this, Obd2::BATTERY_VOLTAGE, voltagePeriod);
+      pinMode(wakePin, INPUT_PULLUP);
+      attachInterrupt(digitalPinToInterrupt(wakePin), onWakeInterrupt, FALLING);
+      this->modeStartTime = millis();
+      this->lastReportTime = millis();
+    }
+
+    // class loop
+    void loop()
+    {
+      unsigned long now = millis();
+      if (now - this->lastReportTime >= reportPeriod) {
+        this->lastReportTime = now;
+        this->printReport();
+      }
+
+      if (this->powerState == POWER_STATE_ACTIVE) {
+        unsigned long sinceResponse = now - this->obd2.getLastResponseTime();
+        bool lowVoltage = this->lastVolts > 0 && this->lastVolts < engineRunningVolts;
+        if (sinceResponse >= idleTimeout || (lowVoltage && sinceResponse >= lowVoltageIdleTimeout)) {
+          this->setPowerState(POWER_STATE_IDLE);
+        }
+        return;
+      }
+
+      // idle: wake on button press or an answer from the car
+      if (wakeRequested() == true || this->obd2.getLastResponseTime() != this->idleResponseTime) {
+        wakeRequested() = false;
+        this->setPowerState(POWER_STATE_ACTIVE);
+        return;
+      }
+
+      // let a pending request finish so Obd2 can publish it
+      if (this->obd2.isBusy()) {
+        this->sleepFor(Obd2::obdBusyPeriod);
+        return;
+      }
+
+      // one heartbeat request per loop, run time first when both are due so voltage can't starve it
+      unsigned long sinceRunTime = now - this->lastRunTimeHeartbeatTime;
+      if (sinceRunTime >= runTimeHeartbeatPeriod) {
+        this->lastRunTimeHeartbeatTime = now;
+        this->obd2.makePidRequest(Obd2::RUN_TIME_SINCE_ENGINE_START);
+        return;
+      }
+      unsigned long sinceVoltage = now - this->lastVoltageHeartbeatTime;
+      if (sinceVoltage >= voltageHeartbeatPeriod) {
+        this->lastVoltageHeartbeatTime = now;
+        this->obd2.makePidRequest(Obd2::BATTERY_VOLTAGE);
+        return;
+      }
+      this->sleepFor(min(voltageHeartbeatPeriod - sinceVoltage, runTimeHeartbeatPeriod - sinceRunTime));
+    }
+
+    // watch battery voltage, the alternator pushes it above 13.2V while the engine runs
+    void onSample(const Sample &sample)
+    {
+      this->lastVolts = sample.value;
+      if (this->powerState == POWER_STATE_IDLE && sample.value >= engineRunningVolts) {
+        this->setPowerState(POWER_STATE_ACTIVE);
+      }
+    }
+
+    // should rendering and the rest of loop() be skipped?
+    bool isIdle()
+    {
+      return this->powerState == POWER_STATE_IDLE;
+    }
+
+    // print time spent in each mode and CPU duty cycle while idle
+    void printReport()
+    {
+      unsigned long inMode = millis() - this->modeStartTime;
+      unsigned long active = this->activeTime + (this->powerState == POWER_STATE_ACTIVE ? inMode : 0);
+      unsigned long idle = this->idleTime + (this->powerState == POWER_STATE_IDLE ? inMode : 0);
+      Serial.print(F("Active: "));
+      Serial.print(active / 1000);
+      Serial.print(F("s (100% duty), idle: "));
+      Serial.print(idle / 1000);
+      Serial.print(F("s ("));
+      Serial.print(idle > 0 ? 100.0 * (idle - this->sleepTime) / idle : 0.0, 1);
+      Serial.println(F("% duty)"));
+    }
+
+  // private class methods
+  private:
+    void setPowerState(int newState)
+    {
+      if (newState == this->powerState) {
+        return;
+      }
+      unsigned long now = millis();
+      if (this->powerState == POWER_STATE_ACTIVE) {
+        this->activeTime += now - this->modeStartTime;
+      } else {
+        this->idleTime += now - this->modeStartTime;
+      }
+      this->modeStartTime = now;
+      this->powerState = newState;
+
+      if (newState == POWER_STATE_IDLE) {
+        Serial.println(F("Engine off, entering idle mode."));
+        this->obd2.setPolling(false);
+        this->lastVoltageHeartbeatTime = now;
+        this->lastRunTimeHeartbeatTime = now;
+        this->idleResponseTime = this->obd2.getLastResponseTime();
+        wakeRequested() = false;
+      } else {
+        Serial.println(F("Engine on, leaving idle mode."));
+        this->obd2.setPolling(true);
+      }
+      this->printReport();
+    }
+
+    // halt the CPU until the next interrupt, over and over, until time is up or the button wakes us
+    // the millis() timer interrupt wakes the CPU every millisecond, so this also keeps time
+    void sleepFor(unsigned long duration)
+    {
+      unsigned long start = millis();
+      while (millis() - start < duration && wakeRequested() == false) {
+        #if defined(__AVR__)
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+        #elif defined(__arm__)
+        __WFI();
+        #endif
+      }
+      this->sleepTime += millis() - start;
+    }
+};
+
+#endif
@@ -4,7 +4,7 @@
  */
 
  #ifndef RtcUtils_h
- #define RtcUItils_h
+ #define RtcUtils_h
 
  #include <Arduino.h>
  #include <SparkFun_RV1805.h>
@@ -18,8 +18,10 @@
     }
 
     // get a YYYYMMDDHHMMSS string of current RTC date/time
+    // Rtc is RV1805 in the car, or anything with the same methods (ScriptedRtc in benchmarks)
     // TODO: This assumes rtc.set24Hour(); was set first, should I check every time here and toggle? Hmm...
-    char* getDateTime(RV1805 &rtc)
+    template <class Rtc>
+    char* getDateTime(Rtc &rtc)
     {
       if (rtc.updateTime() == true)
       {
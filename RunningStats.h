@@ -0,0 +1,80 @@
+/*
+ * RunningStats.h - Count, mean, min/max and variance of a signal in constant memory
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef RunningStats_h
+ #define RunningStats_h
+
+ #include <Arduino.h>
+
+ class RunningStats {
+  // define class variables
+  unsigned long count; // values added so far
+  float mean; // running mean
+  float m2; // sum of squared differences from the mean (Welford), variance = m2 / count
+  long minValue;
+  long maxValue;
+
+  // public class methods
+  public:
+    // constructor
+    RunningStats()
+    {
+      this->reset();
+    }
+
+    // forget all values
+    void reset()
+    {
+      this->count = 0;
+      this->mean = 0;
+      this->m2 = 0;
+      this->minValue = 0;
+      this->maxValue = 0;
+    }
+
+    // add a value without storing it
+    // many thanks: https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm
+    void add(long value)
+    {
+      this->count += 1;
+      const float delta = value - this->mean;
+      this->mean += delta / this->count;
+      this->m2 += delta * (value - this->mean);
+      if (this->count == 1 || value < this->minValue) {
+        this->minValue = value;
+      }
+      if (this->count == 1 || value > this->maxValue) {
+        this->maxValue = value;
+      }
+    }
+
+    unsigned long getCount()
+    {
+      return this->count;
+    }
+
+    float getMean()
+    {
+      return this->mean;
+    }
+
+    long getMin()
+    {
+      return this->minValue;
+    }
+
+    long getMax()
+    {
+      return this->maxValue;
+    }
+
+    // population variance
+    float getVariance()
+    {
+      return this->count > 0 ? this->m2 / this->count : 0;
+    }
+};
+
+#endif
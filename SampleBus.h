@@ -0,0 +1,144 @@
+/*
+ * SampleBus.h - Share each decoded OBD-II reading with every class that wants it
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef SampleBus_h
+ #define SampleBus_h
+
+ #include <Arduino.h>
+
+ // one decoded reading, published once by Obd2
+ struct Sample {
+   byte pid; // mode 01 PID, e.g. 0x0D for speed
+   unsigned long timestamp; // millis() when the reading was decoded
+   long value; // decoded value in the PID's units, long as 2 byte PIDs go up to 65,535 (int is 16 bits on AVR)
+ };
+
+ // implemented by anything that wants readings: loggers, predictors, screens...
+ class SampleSubscriber {
+  public:
+    virtual void onSample(const Sample &sample) = 0;
+ };
+
+ // subscriptions live in the StaticSampleBus below, sized by the sketch, everything else takes a SampleBus&
+ class SampleBus {
+  protected:
+  // a subscriber's interest in one PID at a given rate
+  struct Subscription {
+    SampleSubscriber* subscriber;
+    byte pid;
+    unsigned long period; // deliver at most once per period (ms)
+    unsigned long lastServed; // millis() of last delivery (or failed attempt)
+    bool served; // false until first delivery/attempt
+  };
+
+  private:
+  Subscription* subscriptions; // storage supplied by StaticSampleBus
+  byte maxSubscriptions;
+  byte subscriptionCount = 0;
+
+  protected:
+    // constructor, declare a StaticSampleBus<capacity> to get one
+    SampleBus(Subscription* subscriptions, byte maxSubscriptions):
+      // member initializer list
+      subscriptions(subscriptions),
+      maxSubscriptions(maxSubscriptions)
+    {
+    }
+
+  // public class methods
+  public:
+    // returned by getNextDuePid() when nothing is due
+    const static byte NO_PID = 0xFF;
+
+    // ask for a PID at most once per period (ms)
+    // a full bus is a sketch bug (capacity doesn't match what setup() subscribes), so freeze here where it's seen on the bench
+    // instead of quietly dropping readings some class depends on
+    void subscribe(SampleSubscriber &subscriber, byte pid, unsigned long period)
+    {
+      if (this->subscriptionCount >= this->maxSubscriptions) {
+        Serial.println(F("SampleBus is full, raise its capacity in the sketch. Freezing."));
+        while (true) {
+        }
+      }
+      Subscription &subscription = this->subscriptions[this->subscriptionCount++];
+      subscription.subscriber = &subscriber;
+      subscription.pid = pid;
+      subscription.period = period;
+      subscription.lastServed = 0;
+      subscription.served = false;
+    }
+
+    // the most overdue PID across all subscribers, so overlapping demand becomes one request
+    byte getNextDuePid(unsigned long now)
+    {
+      byte duePid = NO_PID;
+      unsigned long mostOverdue = 0;
+      for (byte i=0; i<this->subscriptionCount; i++)
+      {
+        Subscription &subscription = this->subscriptions[i];
+        if (subscription.served == false) {
+          // never served: due right away
+          return subscription.pid;
+        }
+        unsigned long elapsed = now - subscription.lastServed;
+        if (elapsed >= subscription.period && elapsed - subscription.period >= mostOverdue) {
+          mostOverdue = elapsed - subscription.period;
+          duePid = subscription.pid;
+        }
+      }
+      return duePid;
+    }
+
+    // hand a decoded reading to every subscriber of its PID whose rate filter lets it through
+    void publish(const Sample &sample)
+    {
+      for (byte i=0; i<this->subscriptionCount; i++)
+      {
+        Subscription &subscription = this->subscriptions[i];
+        if (subscription.pid == sample.pid && this->isDue(subscription, sample.timestamp)) {
+          subscription.lastServed = sample.timestamp;
+          subscription.served = true;
+          subscription.subscriber->onSample(sample);
+        }
+      }
+    }
+
+    // a request for this PID failed: back off until each subscriber's next period instead of retrying every loop
+    void skip(byte pid, unsigned long now)
+    {
+      for (byte i=0; i<this->subscriptionCount; i++)
+      {
+        Subscription &subscription = this->subscriptions[i];
+        if (subscription.pid == pid && this->isDue(subscription, now)) {
+          subscription.lastServed = now;
+          subscription.served = true;
+        }
+      }
+    }
+
+  // private class methods
+  private:
+    bool isDue(Subscription &subscription, unsigned long now)
+    {
+      return subscription.served == false || now - subscription.lastServed >= subscription.period;
+    }
+};
+
+ // capacity is a template parameter so subscriptions are sized at compile time and live in static storage
+ // the sketch adds up each subscriber's sampleSubscriptionCount for it
+ template <byte capacity>
+ class StaticSampleBus : public SampleBus {
+  // define class variables
+  Subscription storage[capacity];
+
+  // public class methods
+  public:
+    // constructor
+    StaticSampleBus(): SampleBus(this->storage, capacity)
+    {
+    }
+};
+
+#endif
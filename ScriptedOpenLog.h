@@ -0,0 +1,37 @@
+/*
+ * ScriptedOpenLog.h - Discard what's written, with the OpenLog methods DataLogger uses, a stand-in for the OpenLog in benchmarks and tests
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef ScriptedOpenLog_h
+ #define ScriptedOpenLog_h
+
+ #include <Arduino.h>
+
+ class ScriptedOpenLog : public Print {
+  // public class methods
+  public:
+    bool begin()
+    {
+      return true;
+    }
+
+    // takes a String like the OpenLog, so the file name copy is timed too
+    bool append(String fileName)
+    {
+      return fileName.length() > 0;
+    }
+
+    bool syncFile()
+    {
+      return true;
+    }
+
+    // lines go nowhere
+    size_t write(uint8_t c)
+    {
+      return 1;
+    }
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * ScriptedRtc.h - A fixed date/time with the RV1805 methods RtcUtils uses, a stand-in for the RTC in benchmarks and tests
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef ScriptedRtc_h
+ #define ScriptedRtc_h
+
+ #include <Arduino.h>
+
+ class ScriptedRtc {
+  // define class variables
+  byte year; // 2 digit year, like the RV1805
+  byte month;
+  byte date;
+  byte hours; // 24 hour
+  byte minutes;
+  byte seconds;
+  bool connected; // false to script a failed updateTime(), like a missing RTC
+
+  // public class methods
+  public:
+    // constructor
+    ScriptedRtc(byte year, byte month, byte date, byte hours, byte minutes, byte seconds, bool connected = true):
+      // member initializer list
+      year(year),
+      month(month),
+      date(date),
+      hours(hours),
+      minutes(minutes),
+      seconds(seconds),
+      connected(connected)
+    {
+    }
+
+    bool updateTime()
+    {
+      return this->connected;
+    }
+
+    byte getYear()
+    {
+      return this->year;
+    }
+
+    byte getMonth()
+    {
+      return this->month;
+    }
+
+    byte getDate()
+    {
+      return this->date;
+    }
+
+    byte getHours()
+    {
+      return this->hours;
+    }
+
+    byte getMinutes()
+    {
+      return this->minutes;
+    }
+
+    byte getSeconds()
+    {
+      return this->seconds;
+    }
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * ScriptedStream.h - Replay a fixed script as a Stream, a stand-in for the OBD-II UART in benchmarks and tests
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef ScriptedStream_h
+ #define ScriptedStream_h
+
+ #include <Arduino.h>
+
+ class ScriptedStream : public Stream {
+  // define class variables
+  const char* script; // characters to replay
+  int scriptIndex = 0; // next character to read
+  bool repeat; // start over at the end of the script, or run dry
+
+  // public class methods
+  public:
+    // constructor
+    ScriptedStream(const char* script, bool repeat = true):
+      // member initializer list
+      script(script),
+      repeat(repeat)
+    {
+    }
+
+    int available()
+    {
+      return this->script[this->scriptIndex] != '\0' ? 1 : 0;
+    }
+
+    int peek()
+    {
+      return this->available() ? this->script[this->scriptIndex] : -1;
+    }
+
+    int read()
+    {
+      if (this->available() == 0) {
+        return -1;
+      }
+      char c = this->script[this->scriptIndex++];
+      if (this->repeat && this->script[this->scriptIndex] == '\0') {
+        this->scriptIndex = 0;
+      }
+      return c;
+    }
+
+    // requests go nowhere
+    size_t write(uint8_t c)
+    {
+      return 1;
+    }
+
+    void flush()
+    {
+    }
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * TripDetector.h - Detect trips on the device and log one summary line per trip instead of raw readings
+ * Created by agent (agent@local) on 10/19/26
+ */
+
+ #ifndef TripDetector_h
+ #define TripDetector_h
+
+ #include <Arduino.h>
+ #include <SparkFun_Qwiic_OpenLog_Arduino_Library.h>
+
+ #include "RtcUtils.h" // format dates for logs
+ #include "Obd2.h" // PID constants
+ #include "SampleBus.h" // readings arrive here from Obd2
+ #include "RunningStats.h" // constant memory aggregates per signal
+
+ class TripDetector : public SampleSubscriber {
+  // define class variables
+  RV1805& rtc; // reference shared RTC clock instance
+  OpenLog& openLog; // reference shared OpenLog instance
+  SampleBus& sampleBus; // reference shared SampleBus instance
+  RtcUtils rtcUtils; // create RTC utils instance
+  const static unsigned long runTimePeriod = 10000; // 10 seconds between engine run time checks
+  const static unsigned long signalPeriod = 1000; // 1 second between speed/load readings
+  const static unsigned long tripEndTimeout = 30000; // 30 seconds without any reading: engine is off, trip is over
+  const static unsigned long maxSpeedGap = 10000; // don't integrate distance across gaps longer than 10 seconds
+  const char* logFile = "trips.txt";
+
+  // speed bands for time at speed: idle (0), city (1 - 49), rural (50 - 89), highway (90+) km/h
+  const static byte speedBandCount = 4;
+  const int speedBandMin[speedBandCount] = {0, 1, 50, 90};
+
+  // trip state
+  bool tripActive = false;
+  char tripStartDateTime[15]; // YYYYMMDDHHMMSS of trip start, empty if RTC unavailable
+  unsigned long tripStartTime; // millis() at trip start
+  unsigned long lastSampleTime; // millis() of the last reading of any kind
+  long lastRunTime; // last engine run time (seconds), a smaller value means the engine was restarted
+  RunningStats speedStats;
+  RunningStats loadStats;
+  bool hasLastSpeed;
+  int lastSpeed; // km/h
+  unsigned long lastSpeedTime;
+  float distanceKm; // integral of speed over time
+  unsigned long timeInSpeedBand[speedBandCount]; // ms spent in each speed band
+
+  // public class methods
+  public:
+    // subscriptions made in setup(), the sketch sizes SampleBus from these
+    const static byte sampleSubscriptionCount = 3;
+
+    // constructor
+    TripDetector(RV1805 &rtc, OpenLog &openLog, SampleBus &sampleBus):
+      // member initializer list
+      rtc(rtc),
+      openLog(openLog),
+      sampleBus(sampleBus)
+    {
+    }
+
+    // class setup
+    void setup()
+    {
+      this->sampleBus.subscribe(*this, Obd2::RUN_TIME_SINCE_ENGINE_START, runTimePeriod);
+      this->sampleBus.subscribe(*this, Obd2::SPEED, signalPeriod);
+      this->sampleBus.subscribe(*this, Obd2::ABSOLUTE_LOAD_VALUE, signalPeriod);
+    }
+
+    // class loop
+    void loop()
+    {
+      // the car stops answering once the engine is off
+      if (this->tripActive && millis() - this->lastSampleTime >= tripEndTimeout) {
+        this->endTrip();
+      }
+    }
+
+    // fold a reading into the current trip
+    void onSample(const Sample &sample)
+    {
+      if (sample.pid == Obd2::RUN_TIME_SINCE_ENGINE_START) {
+        if (this->tripActive && sample.value < this->lastRunTime) {
+          // run time went backwards: engine was stopped or restarted between readings
+          this->endTrip();
+        }
+        // ignition on with the engine off answers with a run time of 0, that's not a trip
+        if (this->tripActive == false && sample.value > 0) {
+          this->startTrip(sample.timestamp);
+        }
+        this->lastRunTime = sample.value;
+      } else if (sample.pid == Obd2::SPEED && this->tripActive == false && sample.value > 0) {
+        // moving is a trip too, even if run time isn't available (e.g. CAN monitoring)
+        this->startTrip(sample.timestamp);
+        this->lastRunTime = 0;
+      }
+
+      if (this->tripActive == false) {
+        return;
+      }
+      this->lastSampleTime = sample.timestamp;
+
+      if (sample.pid == Obd2::SPEED) {
+        this->addSpeed(sample.value, sample.timestamp);
+      } else if (sample.pid == Obd2::ABSOLUTE_LOAD_VALUE) {
+        this->loadStats.add(sample.value);
+      }
+    }
+
+  // private class methods
+  private:
+    // reset aggregates for a new trip
+    void startTrip(unsigned long timestamp)
+    {
+      this->tripActive = true;
+      this->tripStartTime = timestamp;
+      this->lastSampleTime = timestamp;
+      this->speedStats.reset();
+      this->loadStats.reset();
+      this->hasLastSpeed = false;
+      this->distanceKm = 0;
+      for (byte i=0; i<speedBandCount; i++)
+      {
+        this->timeInSpeedBand[i] = 0;
+      }
+
+      // get the YYYYMMDDHHMMSS timestamp
+      const char* dateTime = this->rtcUtils.getDateTime(this->rtc);
+      strncpy(this->tripStartDateTime, dateTime != 0 ? dateTime : "", sizeof(this->tripStartDateTime));
+      this->tripStartDateTime[sizeof(this->tripStartDateTime) - 1] = '\0';
+      Serial.println(F("Trip started."));
+    }
+
+    // integrate distance and time at speed between consecutive speed readings
+    void addSpeed(int speed, unsigned long timestamp)
+    {
+      this->speedStats.add(speed);
+      if (this->hasLastSpeed) {
+        unsigned long dt = timestamp - this->lastSpeedTime;
+        if (dt <= maxSpeedGap) {
+          // trapezoid rule, km/h * ms -> km
+          this->distanceKm += (this->lastSpeed + speed) / 2.0 * dt / 3600000.0;
+          this->timeInSpeedBand[this->getSpeedBand(this->lastSpeed)] += dt;
+        }
+      }
+      this->hasLastSpeed = true;
+      this->lastSpeed = speed;
+      this->lastSpeedTime = timestamp;
+    }
+
+    byte getSpeedBand(int speed)
+    {
+      byte band = 0;
+      for (byte i=0; i<speedBandCount; i++)
+      {
+        if (speed >= this->speedBandMin[i]) {
+          band = i;
+        }
+      }
+      return band;
+    }
+
+    // write one summary line for the finished trip:
+    // start,durationS,distanceKm,speedMean,speedMax,loadMean,loadMin,loadMax,loadStdDev,idleS,cityS,ruralS,highwayS
+    void endTrip()
+    {
+      this->tripActive = false;
+      const unsigned long durationMs = this->lastSampleTime - this->tripStartTime;
+
+      String logLine = String(this->tripStartDateTime) + "," + String(durationMs / 1000) + "," + String(this->distanceKm, 1);
+      logLine += "," + String(this->speedStats.getMean(), 1) + "," + String(this->speedStats.getMax());
+      logLine += "," + String(this->loadStats.getMean(), 1) + "," + String(this->loadStats.getMin()) + "," + String(this->loadStats.getMax());
+      logLine += "," + String(sqrt(this->loadStats.getVariance()), 1);
+      for (byte i=0; i<speedBandCount; i++)
+      {
+        logLine += "," + String(this->timeInSpeedBand[i] / 1000);
+      }
+
+      this->openLog.append(this->logFile);
+      this->openLog.println(logLine);
+      this->openLog.syncFile();
+      Serial.print(F("trip: "));
+      Serial.println(logLine);
+    }
+};
+
+#endif
@@ -12,9 +12,16 @@
 #include "OledWarpField.h" // A star warp field for SparkFun Micro OLED Qwiic
 #include "OledOilChangePrediction.h" // Show hours/days prediction to the next oil change on a SparkFun Micro OLED Qwiic
 #include "OledTroubleCodes.h" // Cycle through active trouble code alerts on a SparkFun Micro OLED Qwiic
+#include "SampleBus.h" // Share each OBD-II reading with every subscriber, merging their requests
 #include "Obd2.h" // Communicate with the car via SparkFun Car OBD-II UART
 #include "DataLogger.h" // Log car data with SparkFun OpenLog Qwiic, SparkFun Real Time Clock Module - RV-1805 (Qwiic) and SparkFun OBD-II UART
+#include "CanMonitor.h" // Optional passive CAN broadcast monitoring with the STN1110 instead of polling
+#include "OilChangePredictor.h" // Predict hours to the next oil change from distance since codes cleared
+#include "TripDetector.h" // Detect trips and log one summary line per trip with SparkFun OpenLog Qwiic
+#include "FlightRecorder.h" // Capture high-rate readings in RAM, write them to OpenLog only around trouble codes and fuel trim excursions
+#include "PowerManager.h" // Engine-off idle mode: stop rendering, poll heartbeats and sleep in between
 #include "Button1.h" // Uses SparkFun Qwiic Button to detect short clicks and long presses
+#include "MemoryBudget.h" // Report the size of each subsystem object and library statics, RAM_BUDGET_BYTES is enforced at compile time below
 
 // set state of app, determining what will be displayed
 const byte STATE_OIL_CHANGE_PREDICTION = 0;
@@ -26,42 +33,105 @@ int demoLoopFrames = 300;
 int demoLoopFramesInt = 0;
 int demoLoopFramesToggle = true;
 
+// All subsystems below live in static storage (no new) so their RAM use is known at link time and checked against RAM_BUDGET_BYTES
+
 // MicroOLED
 //The library assumes a reset pin is necessary. The Qwiic OLED has RST hard-wired, so pick an arbitrarty IO pin that is not being used
 #define PIN_RESET 9
 //The DC_JUMPER is the I2C Address Select jumper. Set to 1 if the jumper is open (Default), or set to 0 if it's closed.
 #define DC_JUMPER 1
-MicroOLED* oled;
+MicroOLED oled(PIN_RESET, DC_JUMPER);
 
-// create instance of OledWarpField class
-OledWarpField* oledWarpField;
+// create instance of OledWarpField class (fewer stars on AVR, where each one is 12 bytes of a 2.5 KB SRAM)
+#if defined(__AVR__)
+const byte warpFieldStarCount = 10;
+#else
+const byte warpFieldStarCount = 15;
+#endif
+OledWarpField<warpFieldStarCount> oledWarpField(oled);
 
 // declare OledTroubleCodes class
 String troubleCodes[10]; // make room for up to 10 trouble codes for now
-OledTroubleCodes* oledTroubleCodes;
+OledTroubleCodes oledTroubleCodes(oled);
 
 // Button1 setup
-Button1* button1;
+Button1 button1;
+// Qwiic Button INT pin, wakes us from idle mode with a press
+#define PIN_BUTTON_INTERRUPT 7
 
 // declare RTC clock
-// Note: init class later as Wire (I2C communication) is initialized at this level with higher speed set, also
+// Note: rtc.begin() is called later as Wire (I2C communication) is initialized at this level with higher speed set, also
 // initialized in RV1805. If RV1805 Wire.begin() is called in before Wire.begin() here (car-psychic.ino), this sketch freezes
-RV1805* rtc;
+RV1805 rtc;
 
 // declare OpenLog
 const int ledPin = 13; //Status LED connected to digital pin 13
 const byte OpenLogAddress = 42; //Default Qwiic OpenLog I2C address
-OpenLog* openLog;
-
-// declare Obd2 class
-Obd2* obd2;
+OpenLog openLog;
+
+// raw readings are optional now that TripDetector logs per-trip summaries, set to 0 to save card space
+// off by default on AVR: its 15 SampleBus subscriptions don't fit a 2.5 KB atmega32u4 next to everything else
+#if defined(__AVR__)
+#define LOG_RAW_SAMPLES 0
+#else
+#define LOG_RAW_SAMPLES 1
+#endif
+
+// FlightRecorder ring buffer entries (around 3 seconds at 16 on AVR, 6 at 32 elsewhere, half of it after a trigger)
+#if defined(__AVR__)
+const byte flightRecorderCapacity = 16;
+#else
+const byte flightRecorderCapacity = 32;
+#endif
+
+// declare SampleBus, Obd2 publishes readings here for DataLogger, TripDetector, OilChangePredictor, FlightRecorder and PowerManager
+// sized from the subscriptions each of them makes in setup(), a subscriber missing here freezes setup() with a message
+const byte sampleBusCapacity =
+  (LOG_RAW_SAMPLES ? DataLogger<>::sampleSubscriptionCount : 0) + TripDetector::sampleSubscriptionCount +
+  OilChangePredictor::sampleSubscriptionCount + FlightRecorder<flightRecorderCapacity>::sampleSubscriptionCount +
+  PowerManager::sampleSubscriptionCount;
+StaticSampleBus<sampleBusCapacity> sampleBus;
+
+// declare Obd2 class, talking to the OBD-II UART on Serial1 (begun in setupSerial())
+Obd2 obd2(sampleBus, Serial1);
+
+// passive CAN monitoring: set to 1 and fill canSignals[] with your car's broadcast IDs/bit layouts (see CanMonitor.h), left out of the build at 0
+// readings arrive at tens of Hz without requests, but only signals in the table are available while the engine runs
+#define CAN_MONITOR 0
+#if CAN_MONITOR
+const CanSignal canSignals[] = {
+  // id, DBC startBit, length, bigEndian, isSigned, scale, offset, pid (example: Toyota, from opendbc: SPEED : 47|16@0+, RPM : 7|16@0-)
+  {0x0B4, 47, 16, true, false, 0.01, 0, Obd2::SPEED},
+  {0x2C4, 7, 16, true, true, 0.78125, 0, Obd2::ENGINE_RPM}
+};
+CanMonitor canMonitor(obd2, sampleBus, canSignals, sizeof(canSignals) / sizeof(canSignals[0]), Serial1);
+#endif
 
 // declare FuelTankLogger class
-DataLogger* dataLogger;
+DataLogger<> dataLogger(rtc, openLog, sampleBus);
+
+// declare TripDetector class
+TripDetector tripDetector(rtc, openLog, sampleBus);
 
 // next oil change prediction
 float nextOilChangeHours;
-OledOilChangePrediction* oledOilChangePrediction;
+OilChangePredictor oilChangePredictor(sampleBus);
+
+// declare FlightRecorder
+FlightRecorder<flightRecorderCapacity> flightRecorder(rtc, openLog, sampleBus);
+OledOilChangePrediction oledOilChangePrediction(oled);
+
+// declare PowerManager class
+PowerManager powerManager(obd2, sampleBus);
+bool displayOn = true; // OLED is turned off while idle
+
+// fail the build if the subsystems and library statics outgrow their RAM budget (see MemoryBudget.h)
+static_assert(
+  LIBRARY_STATIC_BYTES + sizeof(oled) + sizeof(oledWarpField) + sizeof(troubleCodes) + sizeof(oledTroubleCodes) + sizeof(button1) +
+  sizeof(rtc) + sizeof(openLog) + sizeof(sampleBus) + sizeof(obd2) + (CAN_MONITOR ? sizeof(CanMonitor) : 0) + sizeof(dataLogger) +
+  sizeof(tripDetector) + sizeof(oilChangePredictor) + sizeof(flightRecorder) + sizeof(powerManager) + sizeof(oledOilChangePrediction) <= RAM_BUDGET_BYTES,
+  "Subsystems and library statics exceed RAM_BUDGET_BYTES, see MemoryBudget.h"
+);
 
 // setup() is a required starting point for Arduino sketches
 void setup() {
@@ -81,37 +151,48 @@ void setup() {
   setupRtc();
 
   // Button1 setup
-  button1 = new Button1();
-  button1->setup();
+  button1.setup(PIN_BUTTON_INTERRUPT);
 
   // OBD-II UART setup
-  obd2 = new Obd2();
-  obd2->setup();
+  obd2.setup();
+
+  // data logger setup (only subscribes to readings if raw logging is on)
+  #if LOG_RAW_SAMPLES
+  dataLogger.setup();
+  #endif
 
-  // data logger setup
-  dataLogger = new DataLogger(*rtc, *openLog, *obd2);
-  dataLogger->setup();
+  // trip summary setup
+  tripDetector.setup();
+
+  // oil change prediction setup
+  oilChangePredictor.setup();
+
+  // flight recorder setup
+  flightRecorder.setup();
+
+  // idle mode setup
+  powerManager.setup(PIN_BUTTON_INTERRUPT);
 
   // warp field background display setup
-  oledWarpField = new OledWarpField(*oled, 15);
-  oledWarpField->setup();
+  oledWarpField.setup();
 
   // oil change prediction shown over warp field background setup
-  oledOilChangePrediction = new OledOilChangePrediction(*oled);
-  oledOilChangePrediction->setup();
+  oledOilChangePrediction.setup();
 
   // trouble code display setup
-  oledTroubleCodes = new OledTroubleCodes(*oled);
-  oledTroubleCodes->setup();
+  oledTroubleCodes.setup();
+
+  // print the size of each subsystem object and stack headroom
+  printMemoryBudget();
 
   // TEMPORARY
   troubleCodes[0] = "P0171";
   troubleCodes[1] = "P0300";
   troubleCodes[2] = "C0031";
-  oledTroubleCodes->setTroubleCodes(troubleCodes);
+  oledTroubleCodes.setTroubleCodes(troubleCodes);
   // setState(STATE_TROUBLE_CODES);
   nextOilChangeHours = 550;
-  oledOilChangePrediction->setOilChangeHours(nextOilChangeHours);
+  oledOilChangePrediction.setOilChangeHours(nextOilChangeHours);
   setState(STATE_OIL_CHANGE_PREDICTION);
   // END TEMPORARY
 
@@ -121,15 +202,36 @@ void setup() {
 
 // loop() is an Arduino required method that will start running after setup()
 void loop() {
-  oled->clear(PAGE);  // Clear the OLED buffer
+  powerManager.loop(); // sleeps between heartbeats while idle
+  #if CAN_MONITOR
+  // monitor while the engine runs, PowerManager's heartbeat needs the UART back while idle
+  if (powerManager.isIdle()) {
+    canMonitor.stop();
+  } else {
+    canMonitor.start();
+  }
+  canMonitor.loop();
+  #endif
   //checkForTroubleCodes();
   manageButtonActions();
-  button1->loop();
-  obd2->loop();
-  dataLogger->loop();
-  oledWarpField->loop();
-  oledTroubleCodes->loop();
-  oledOilChangePrediction->loop();
+  button1.loop();
+  obd2.loop();
+  dataLogger.loop();
+  tripDetector.loop();
+  flightRecorder.loop();
+  updateOilChangePrediction();
+
+  // engine off: nothing to see, turn the OLED off and skip rendering
+  if (powerManager.isIdle()) {
+    setDisplayOn(false);
+    return;
+  }
+  setDisplayOn(true);
+
+  oled.clear(PAGE);  // Clear the OLED buffer
+  oledWarpField.loop();
+  oledTroubleCodes.loop();
+  oledOilChangePrediction.loop();
 
   // TEMPORARY DEMO STATE CHANGES
   if (demoLoopFramesToggle == true) {
@@ -142,14 +244,17 @@ void loop() {
     demoLoopFramesInt = 0;
     demoLoopFramesToggle = !demoLoopFramesToggle;
   }
-  oled->display(); // Draw the OLED memory buffer
+  oled.display(); // Draw the OLED memory buffer
 }
 
-// setup serial port output
+// setup serial port output and the OBD-II UART
 void setupSerial()
 {
   Serial.begin(9600);
-  Serial.println("Debugging has begun.");
+  Serial.println(F("Debugging has begun."));
+
+  // OBD-II UART
+  Serial1.begin(9600);
 }
 
 // Wire setup
@@ -164,29 +269,70 @@ void setupWire()
 // OpenLog setup
 void setupOpenLog()
 {
-  openLog = new OpenLog();
-  openLog->begin();
+  openLog.begin();
 }
 
 // OLED setup
 void setupOled()
 {
-  oled = new MicroOLED(PIN_RESET, DC_JUMPER);
-  oled->begin();    // Initialize the OLED
-  oled->clear(ALL); // Clear the display's internal memory
-  oled->display();  // Display what's in the buffer (splashscreen)
+  oled.begin();    // Initialize the OLED
+  oled.clear(ALL); // Clear the display's internal memory
+  oled.display();  // Display what's in the buffer (splashscreen)
   delay(1000);     // Delay 1000 ms
-  oled->clear(PAGE); // Clear the buffer.
+  oled.clear(PAGE); // Clear the buffer.
 }
 
 // real time clock setup
 void setupRtc()
 {
-  rtc = new RV1805();
-  if (rtc->begin() == false) {
-    Serial.println("Something went wrong with RTC. Check wiring.");
+  if (rtc.begin() == false) {
+    Serial.println(F("Something went wrong with RTC. Check wiring."));
+  }
+  rtc.set24Hour();
+}
+
+// print the size of each subsystem object and the library statics over serial (see MemoryBudget.h for what this leaves out)
+void printMemoryBudget()
+{
+  MemoryBudget memoryBudget;
+  memoryBudget.begin();
+  memoryBudget.add(F("MicroOLED"), sizeof(oled));
+  memoryBudget.add(F("OledWarpField"), sizeof(oledWarpField));
+  memoryBudget.add(F("OledOilChangePrediction"), sizeof(oledOilChangePrediction));
+  memoryBudget.add(F("OledTroubleCodes"), sizeof(oledTroubleCodes) + sizeof(troubleCodes));
+  memoryBudget.add(F("Button1"), sizeof(button1));
+  memoryBudget.add(F("RV1805"), sizeof(rtc));
+  memoryBudget.add(F("OpenLog"), sizeof(openLog));
+  memoryBudget.add(F("SampleBus"), sizeof(sampleBus));
+  memoryBudget.add(F("Obd2"), sizeof(obd2));
+  #if CAN_MONITOR
+  memoryBudget.add(F("CanMonitor"), sizeof(canMonitor));
+  #endif
+  memoryBudget.add(F("DataLogger"), sizeof(dataLogger));
+  memoryBudget.add(F("TripDetector"), sizeof(tripDetector));
+  memoryBudget.add(F("OilChangePredictor"), sizeof(oilChangePredictor));
+  memoryBudget.add(F("FlightRecorder"), sizeof(flightRecorder));
+  memoryBudget.add(F("PowerManager"), sizeof(powerManager));
+  memoryBudget.end();
+}
+
+// show the latest oil change prediction once there is one
+void updateOilChangePrediction()
+{
+  if (oilChangePredictor.getHasPrediction() == true) {
+    nextOilChangeHours = oilChangePredictor.getNextOilChangeHours();
+    oledOilChangePrediction.setOilChangeHours(nextOilChangeHours);
+  }
+}
+
+// turn the OLED panel on/off, only talking to it when that changes
+void setDisplayOn(bool on)
+{
+  if (on == displayOn) {
+    return;
   }
-  rtc->set24Hour();
+  displayOn = on;
+  oled.command(on ? DISPLAYON : DISPLAYOFF);
 }
 
 // set state of the app
@@ -195,17 +341,17 @@ void setState(byte newState)
   switch (newState)
   {
     case STATE_OIL_CHANGE_PREDICTION:
-      oledWarpField->setAnimate(1);
-      oledOilChangePrediction->setAnimate(1);
-      oledTroubleCodes->setAnimate(0);
+      oledWarpField.setAnimate(1);
+      oledOilChangePrediction.setAnimate(1);
+      oledTroubleCodes.setAnimate(0);
       break;
     case STATE_TROUBLE_CODES:
-      oledWarpField->setAnimate(0);
-      oledOilChangePrediction->setAnimate(0);
-      oledTroubleCodes->setAnimate(1);
+      oledWarpField.setAnimate(0);
+      oledOilChangePrediction.setAnimate(0);
+      oledTroubleCodes.setAnimate(1);
       break;
     default:
-      Serial.println("An unknown state attempted to be set.");
+      Serial.println(F("An unknown state attempted to be set."));
   }
   state = newState;
 }
@@ -215,18 +361,20 @@ void setState(byte newState)
 // RESET TROUBLE CODES AT YOUR OWN RISK WITH LONG 5 SECOND PRESS!
 void manageButtonActions()
 {
-  if (button1->getIsShortClicked() == true) {
+  if (button1.getIsShortClicked() == true) {
     // TODO: advance screen
     delay(150); // delay for tactile feedback
     // TODO: less than 150 is causing a multiple resets, more eligant way to do this?
-    button1->resetButtonStatus();
+    button1.resetButtonStatus();
   }
 
   // reset trouble codes (tested car for this experiment had miles since last MIL maxed out and needed reset in order to count miles via generic OBD-II)
   // TODO: continuing to hold button down causes sequence to restart, would be nice to require a new press to do this
-  if (button1->getIsLongPressed() == true) {
-    obd2->makePidRequest(obd2->CLEAR_TROUBLE_CODES);
+  if (button1.getIsLongPressed() == true) {
+    // keep a record of what the car was doing before the codes are gone
+    flightRecorder.triggerNow("button");
+    obd2.makePidRequest(obd2.CLEAR_TROUBLE_CODES);
     delay(2000); // delay for visual feedback
-    button1->resetButtonStatus();
+    button1.resetButtonStatus();
   }
 }
@@ -0,0 +1,194 @@
+/******************************************************************************
+ * benchmarks.ino - Cycles and stack depth of car-psychic hot paths on the real MCU (or under simavr)
+ *
+ * Usually run through run-benchmarks.sh next to this sketch: it builds for the MCU, runs this under simavr,
+ * adds flash per function from avr-nm and gates all three against baselines.txt.
+ * By hand, build against the car-psychic headers by passing the repo root as a library and watch serial:
+ *   arduino-cli compile -b <fqbn> --library /path/to/car-psychic --output-dir build draft-snippets/benchmarks
+ *
+ * Prints one line per benchmark, "BENCH <name> <cycles per call> <stack bytes>", then "BENCHMARKS DONE".
+ * Cycles come from a hardware cycle counter: Timer1 at prescaler 1 on AVR, DWT->CYCCNT on Cortex-M3/M4/M7.
+ * Timer interrupts (millis(), Timer1 overflow) that land inside a benchmark are counted too, the same on every run.
+ * Peripherals are scripted (ScriptedStream for the OBD-II UART, ScriptedRtc for the RV1805, ScriptedOpenLog for the OpenLog),
+ * so nothing here needs I2C. DataLogger's "logged:" debug line goes out on Serial and is timed with it, as in the car.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#include <SFE_MicroOLED.h>
+#if defined(BENCHMARK_SIMULATOR)
+#include <avr/sleep.h>
+#endif
+
+#include <OledWarpField.h>
+#include <SampleBus.h>
+#include <Obd2.h>
+#include <RtcUtils.h>
+#include <DataLogger.h>
+#include <MemoryBudget.h>
+#include <ScriptedStream.h> // scripted stand-in for the OBD-II UART
+#include <ScriptedRtc.h> // scripted stand-in for the RV1805
+#include <ScriptedOpenLog.h> // scripted stand-in for the OpenLog
+
+const int benchmarkIterations = 100; // calls averaged per benchmark
+const byte stackPaint = 0xA5; // free stack is filled with this before each benchmark
+
+// classes under test
+#define PIN_RESET 9
+#define DC_JUMPER 1
+MicroOLED oled(PIN_RESET, DC_JUMPER); // only its buffer is used, begin() and display() are never called
+OledWarpField<15> oledWarpField(oled);
+ScriptedStream obdStream("41 0D 32 \r\r>"); // speed: 50 km/h
+StaticSampleBus<1> sampleBus;
+Obd2 obd2(sampleBus, obdStream);
+ScriptedRtc rtc(26, 10, 19, 13, 45, 30); // 2026-10-19 13:45:30
+ScriptedOpenLog openLog;
+RtcUtils rtcUtils;
+DataLogger<ScriptedRtc, ScriptedOpenLog> dataLogger(rtc, openLog, sampleBus); // subscribed to speed on sampleBus
+Sample sample;
+
+// name (Class::method, run-benchmarks.sh sums flash by class) and function
+// declared before any function so the prototypes the Arduino builder adds there can use it
+struct Benchmark {
+  const char* name;
+  void (*run)();
+};
+
+// noinline so each benchmark has its own symbol in the avr-nm listing
+void __attribute__((noinline)) benchWarpField() { oledWarpField.loop(); }
+void __attribute__((noinline)) benchObd2GetRequestedData() { obd2.getRequestedData(); }
+void __attribute__((noinline)) benchSampleBusPublish() { sampleBus.publish(sample); }
+void __attribute__((noinline)) benchRtcGetDateTime() { rtcUtils.getDateTime(rtc); }
+void __attribute__((noinline)) benchDataLoggerOnSample() { dataLogger.onSample(sample); }
+
+Benchmark benchmarks[] = {
+  {"OledWarpField::animateWarpField", benchWarpField},
+  {"Obd2::getRequestedData", benchObd2GetRequestedData},
+  {"SampleBus::publish", benchSampleBusPublish},
+  {"RtcUtils::getDateTime", benchRtcGetDateTime},
+  {"DataLogger::onSample", benchDataLoggerOnSample}
+};
+const int benchmarkCount = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+#if defined(__AVR__)
+// Timer1 overflows every 65536 cycles, counting them extends it to 32 bits
+volatile unsigned int timer1Overflows = 0;
+ISR(TIMER1_OVF_vect)
+{
+  timer1Overflows++;
+}
+#elif !defined(DWT)
+unsigned long cycleStartMicros; // no cycle counter on this core (e.g. Cortex-M0+)
+#endif
+
+void setup() {
+  Serial.begin(115200); // fast enough that DataLogger's debug line doesn't swamp its cycle count
+  while (!Serial && millis() < 3000); // give native USB boards a moment
+
+  oledWarpField.setup();
+  oledWarpField.setAnimate(1);
+  obd2.makePidRequest(Obd2::SPEED);
+  openLog.begin();
+  sampleBus.subscribe(dataLogger, Obd2::SPEED, 0); // every speed reading, so publish() always delivers to a real subscriber
+  sample.pid = Obd2::SPEED;
+  sample.timestamp = 0;
+  sample.value = 50;
+
+  for (int i=0; i<benchmarkCount; i++)
+  {
+    runBenchmark(benchmarks[i]);
+  }
+  Serial.println("BENCHMARKS DONE");
+
+  #if defined(BENCHMARK_SIMULATOR)
+  // sleeping with interrupts off ends the simavr run
+  Serial.flush();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  cli();
+  sleep_cpu();
+  #endif
+}
+
+void loop() {
+}
+
+// time and measure one benchmark
+void runBenchmark(Benchmark &benchmark)
+{
+  startCycleCounter();
+  for (int i=0; i<benchmarkIterations; i++)
+  {
+    benchmark.run();
+  }
+  unsigned long cycles = readCycleCounter() / benchmarkIterations;
+  unsigned int stack = measureStack(benchmark.run);
+
+  Serial.print("BENCH ");
+  Serial.print(benchmark.name);
+  Serial.print(" ");
+  Serial.print(cycles);
+  Serial.print(" ");
+  Serial.println(stack);
+}
+
+// start counting CPU cycles from 0
+void startCycleCounter()
+{
+  #if defined(__AVR__)
+  TCCR1B = 0; // stop while setting up, the core sets Timer1 up for PWM
+  TCCR1A = 0;
+  TCNT1 = 0;
+  timer1Overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10); // prescaler 1: one count per cycle
+  #elif defined(DWT)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  #else
+  cycleStartMicros = micros();
+  #endif
+}
+
+// CPU cycles since startCycleCounter()
+unsigned long readCycleCounter()
+{
+  #if defined(__AVR__)
+  noInterrupts();
+  unsigned int count = TCNT1;
+  unsigned long overflows = timer1Overflows;
+  // an overflow since interrupts were turned off hasn't reached the ISR yet
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) {
+    overflows++;
+  }
+  interrupts();
+  return (overflows << 16) | count;
+  #elif defined(DWT)
+  return DWT->CYCCNT;
+  #else
+  return (micros() - cycleStartMicros) * (F_CPU / 1000000L); // 1us resolution only
+  #endif
+}
+
+// paint the free stack, run once, and see how far down the paint was overwritten
+// the deepest byte touched, measured from this function's frame, is the stack the benchmark needs
+unsigned int __attribute__((noinline)) measureStack(void (*run)())
+{
+  char top;
+  MemoryBudget memoryBudget;
+  char* stackTop = &top - 32; // leave this frame alone
+  char* stackBottom = stackTop - memoryBudget.getFreeStack() + 64; // stay clear of the heap
+  for (char* p = stackBottom; p < stackTop; p++)
+  {
+    *p = stackPaint;
+  }
+
+  run();
+
+  char* deepest = stackBottom;
+  while (deepest < stackTop && *deepest == (char) stackPaint) {
+    deepest++;
+  }
+  return stackTop - deepest + 32;
+}
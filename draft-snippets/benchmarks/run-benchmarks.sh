@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+# run-benchmarks.sh - Build benchmarks.ino for the MCU, run it under simavr, and gate cycles, stack and flash
+# against the baselines stored in baselines.txt next to this script
+#
+# Usage:
+#   run-benchmarks.sh            compare against baselines.txt, exit 1 on a regression or a missing baseline
+#   run-benchmarks.sh --record   write this run's numbers to baselines.txt (commit it along with the change)
+#
+# Needs on PATH: arduino-cli (arduino:avr core and the SparkFun Micro OLED library installed), simavr and avr-nm.
+# Defaults to the Uno (atmega328p): same AVR core and instruction timings as the atmega32u4, and its Serial is a
+# hardware UART simavr can print, where the 32u4's is native USB. Override with FQBN/MCU, TOLERANCE is in %.
+set -euo pipefail
+
+here="$(cd "$(dirname "$0")" && pwd)"
+repo="$(cd "$here/../.." && pwd)"
+fqbn="${FQBN:-arduino:avr:uno}"
+mcu="${MCU:-atmega328p}"
+fcpu="${F_CPU:-16000000}"
+tolerance="${TOLERANCE:-10}"
+build="$here/build"
+baselines="$here/baselines.txt"
+
+record=0
+if [ "${1:-}" = "--record" ]; then
+  record=1
+elif [ $# -gt 0 ]; then
+  echo "usage: $0 [--record]" >&2
+  exit 2
+fi
+
+arduino-cli compile -b "$fqbn" --library "$repo" --build-property "compiler.cpp.extra_flags=-DBENCHMARK_SIMULATOR" \
+  --output-dir "$build" "$here" > /dev/null
+elf="$build/benchmarks.ino.elf"
+
+# the sketch sleeps with interrupts off when done, which ends the simavr run, timeout is for a hang
+output="$(timeout 300 simavr -m "$mcu" -f "$fcpu" "$elf" 2>&1 | sed 's/\x1b\[[0-9;]*m//g')" || true
+if ! grep -q "BENCHMARKS DONE" <<< "$output"; then
+  echo "$output" >&2
+  echo "FAIL: benchmarks did not finish under simavr" >&2
+  exit 1
+fi
+
+# flash bytes per function for each benchmarked class (what the compiler inlined is counted in its callers)
+symbols="$(avr-nm -S -C -t d --size-sort "$elf")"
+
+# name cycles stack flash, one line per benchmark
+results="$(sed -n 's/.*BENCH \([^ ]*\) \([0-9]*\) \([0-9]*\).*/\1 \2 \3/p' <<< "$output" | while read -r name cycles stack; do
+  class="${name%%::*}"
+  echo "$class flash per function:" >&2
+  echo "$symbols" | grep -E "[tTwW] ${class}(::|<)" | sed 's/^/  /' >&2 || true
+  flash="$(echo "$symbols" | awk -v class="$class" '$3 ~ /^[tTwW]$/ && (index($0, " " class "::") || index($0, " " class "<")) { sum += $2 } END { print sum + 0 }')"
+  echo "$name $cycles $stack $flash"
+done)"
+
+if [ "$record" -eq 1 ]; then
+  {
+    echo "# name cycles stack flash, recorded by run-benchmarks.sh --record on $fqbn ($mcu @ $fcpu Hz)"
+    echo "$results"
+  } > "$baselines"
+  echo "$results"
+  echo "Baselines written to $baselines"
+  exit 0
+fi
+
+if [ ! -f "$baselines" ]; then
+  echo "$results"
+  echo "FAIL: no baselines.txt yet, run $0 --record on a known good build" >&2
+  exit 1
+fi
+
+# compare each metric to its baseline, anything more than tolerance % over it is a regression
+awk -v tolerance="$tolerance" '
+  FNR == NR {
+    if ($1 !~ /^#/ && NF == 4) { baseCycles[$1] = $2; baseStack[$1] = $3; baseFlash[$1] = $4 }
+    next
+  }
+  {
+    line = sprintf("%s: %d cycles, %d stack bytes, %d flash bytes", $1, $2, $3, $4)
+    if (!($1 in baseCycles)) {
+      line = line " FAIL (no baseline)"
+      failed = 1
+    } else {
+      split("cycles stack flash", metrics, " ")
+      split(baseCycles[$1] " " baseStack[$1] " " baseFlash[$1], base, " ")
+      for (i = 1; i <= 3; i++) {
+        if ($(i + 1) > base[i] * (100 + tolerance) / 100) {
+          line = line " FAIL (" metrics[i] " baseline " base[i] ")"
+          failed = 1
+        }
+      }
+    }
+    print line
+  }
+  END {
+    print failed ? "BENCHMARKS FAILED" : "BENCHMARKS PASSED"
+    exit failed
+  }
+' "$baselines" - <<< "$results"
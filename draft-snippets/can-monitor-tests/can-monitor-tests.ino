@@ -0,0 +1,107 @@
+/******************************************************************************
+ * can-monitor-tests.ino - Feed CanMonitor a simulated STN1110 monitor stream and check the decoded signals
+ *
+ * Build against the car-psychic headers by passing the repo root as a library, e.g.:
+ *   arduino-cli compile -b <fqbn> --library /path/to/car-psychic draft-snippets/can-monitor-tests
+ * No car or adapter needed, results are printed to serial.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#include <SampleBus.h>
+#include <Obd2.h>
+#include <CanMonitor.h>
+#include <ScriptedStream.h>
+
+// example layout (Toyota, from opendbc: SPEED : 47|16@0+, RPM : 7|16@0-): speed in 0x0B4 bytes 5-6, rpm in 0x2C4 bytes 0-1
+const CanSignal canSignals[] = {
+  // id, DBC startBit, length, bigEndian, isSigned, scale, offset, pid
+  {0x0B4, 47, 16, true, false, 0.01, 0, Obd2::SPEED},
+  {0x2C4, 7, 16, true, true, 0.78125, 0, Obd2::ENGINE_RPM},
+  {0x123, 4, 8, false, false, 1, -40, Obd2::AIR_INTAKE_TEMP}, // made up, little endian across a byte boundary (4|8@1+)
+  {0x123, 3, 8, true, false, 1, 0, Obd2::ABSOLUTE_LOAD_VALUE} // made up, big endian across a byte boundary (3|8@0+)
+};
+
+// what the adapter prints in monitor mode, including noise the parser has to skip
+ScriptedStream frames(
+  "0B4 00 00 00 00 8E 1F 40 BC\r" // 0x1F40 * 0.01 = 80 km/h
+  "2C4 0B B8 00 00 00 00 00 00\r" // 0x0BB8 * 0.78125 = 2343.75 -> 2344 rpm
+  "BUFFER FULL\r"
+  "2C4 FF 38 00 00 00 00 00 00\r" // -200 * 0.78125 = -156.25 -> -156 rpm (signed)
+  "123 A7 C5\r" // intake temp: byte 1 low nibble, byte 0 high nibble = 0x5A = 90, -40 = 50; load: byte 0 low nibble, byte 1 high nibble = 0x7C = 124
+  "0B4 00 00 00\r" // too short for speed, ignored
+  "7E8 03 41 0D 32\r" // not in the table, ignored
+  ">\r"
+  "0B4 00 00 00 00 8E 0F A0 BC\r", // 0x0FA0 * 0.01 = 40 km/h
+  false
+);
+
+// remember the last value published per PID
+class TestSubscriber : public SampleSubscriber {
+  public:
+    int speed = -999;
+    int rpm = -999;
+    int intakeTemp = -999;
+    int load = -999;
+    int speedCount = 0;
+
+    void onSample(const Sample &sample)
+    {
+      if (sample.pid == Obd2::SPEED) {
+        this->speed = sample.value;
+        this->speedCount += 1;
+      } else if (sample.pid == Obd2::ENGINE_RPM) {
+        this->rpm = sample.value;
+      } else if (sample.pid == Obd2::AIR_INTAKE_TEMP) {
+        this->intakeTemp = sample.value;
+      } else if (sample.pid == Obd2::ABSOLUTE_LOAD_VALUE) {
+        this->load = sample.value;
+      }
+    }
+};
+
+StaticSampleBus<4> sampleBus;
+Obd2 obd2(sampleBus, frames);
+CanMonitor canMonitor(obd2, sampleBus, canSignals, sizeof(canSignals) / sizeof(canSignals[0]), frames);
+TestSubscriber testSubscriber;
+bool passed = true;
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial && millis() < 3000); // give native USB boards a moment
+
+  sampleBus.subscribe(testSubscriber, Obd2::SPEED, 0);
+  sampleBus.subscribe(testSubscriber, Obd2::ENGINE_RPM, 0);
+  sampleBus.subscribe(testSubscriber, Obd2::AIR_INTAKE_TEMP, 0);
+  sampleBus.subscribe(testSubscriber, Obd2::ABSOLUTE_LOAD_VALUE, 0);
+
+  // feed the parser one character at a time, as CanMonitor::loop() would
+  while (frames.available() > 0) {
+    canMonitor.feed(frames.read());
+  }
+
+  check("speed", testSubscriber.speed, 40);
+  check("speed readings", testSubscriber.speedCount, 2);
+  check("rpm", testSubscriber.rpm, -156);
+  check("intake temp", testSubscriber.intakeTemp, 50);
+  check("load", testSubscriber.load, 124);
+  check("frames", canMonitor.getFrameCount(), 7);
+  check("bad lines", canMonitor.getBadLineCount(), 1);
+  Serial.println(passed ? "TESTS PASSED" : "TESTS FAILED");
+}
+
+void loop() {
+}
+
+void check(const char* name, long actual, long expected)
+{
+  Serial.print(actual == expected ? "PASS " : "FAIL ");
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(actual);
+  Serial.print(" (expected ");
+  Serial.print(expected);
+  Serial.println(")");
+  if (actual != expected) {
+    passed = false;
+  }
+}
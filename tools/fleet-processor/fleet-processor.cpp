@@ -0,0 +1,557 @@
+/******************************************************************************
+ * fleet-processor.cpp - Parse, clean and model OpenLog card dumps from many vehicles at once
+ *
+ * Host tool, not part of the sketch. Build with any C++17 compiler:
+ *   g++ -O2 -std=c++17 -pthread -o fleet-processor fleet-processor.cpp
+ *
+ * Usage:
+ *   fleet-processor <fleet dir> [threads]
+ *     <fleet dir> holds one folder per vehicle, each a copy of that car's OpenLog card
+ *     (the DataLogger::logFiles layout: distancesincecleared.txt, speed.txt, ... with YYYYMMDDHHMMSS,value lines)
+ *     Prints one CSV line per vehicle with its next oil change prediction, fleet summary on stderr.
+ *   fleet-processor --bench <vehicles> [lines per file]
+ *     Synthetic fleet kept in memory, run with 1, 2, 4... threads up to all cores to check scaling.
+ *     Measures parsing and modelling only, warm cache: the vehicles share 64 generated cards round-robin and nothing is read
+ *     from disk. For numbers with file I/O, time the first form on a real fleet dir at different thread counts.
+ *
+ * Vehicles are spread over a work-stealing pool: each thread works through its own queue and takes
+ * from the others' once it runs dry, so a few large cards don't leave cores idle.
+ *
+ * Distributed as-is; no warranty is given.
+ ******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// log files written by DataLogger, with the range of values that make sense for each PID
+struct LogFile {
+  const char* name;
+  int minValue;
+  int maxValue;
+};
+const LogFile logFiles[] = {
+  {"stfueltrimb1.txt", -100, 100},
+  {"ltfueltrimb1.txt", -100, 100},
+  {"stfueltrimb2.txt", -100, 100},
+  {"ltfueltrimb2.txt", -100, 100},
+  {"speed.txt", 0, 255},
+  {"intaketemp.txt", -40, 215},
+  {"runtimeenginestart.txt", 0, 65535},
+  {"distancewithmil.txt", 0, 65535},
+  {"warmupssincecleared.txt", 0, 255},
+  {"distancesincecleared.txt", 0, 65535},
+  {"absbarampressure.txt", 0, 255},
+  {"absload.txt", 0, 25700},
+  {"timerunwithmil.txt", 0, 65535},
+  {"timesincecleared.txt", 0, 65535},
+  {"absevapvaporpressure.txt", 0, 65535}
+};
+const int logFileCount = sizeof(logFiles) / sizeof(logFiles[0]);
+const int distanceLogIndex = 9; // distancesincecleared.txt drives the oil change model
+const double oilChangeIntervalKm = 8046; // 5,000 miles, assumes codes are cleared at each oil change (same as OilChangePredictor.h)
+const double minFitDays = 1; // need at least a day of driving to trust a rate
+
+// one cleaned reading
+struct Point {
+  double day; // days since 1970-01-01
+  int value;
+};
+
+// everything we learned about one vehicle
+struct VehicleResult {
+  std::string name;
+  long linesParsed = 0;
+  long linesDropped = 0; // malformed, -999 (failed request), out of range or duplicate
+  bool hasPrediction = false;
+  double lastDay = 0; // last distance reading
+  int distanceKm = 0; // distance since codes cleared at last reading
+  double kmPerDay = 0;
+  double daysToOilChange = 0;
+};
+
+// days since 1970-01-01 for a civil date
+// many thanks: http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+long daysFromCivil(int y, int m, int d)
+{
+  y -= m <= 2;
+  const long era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned) (y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (long) doe - 719468;
+}
+
+// YYYY-MM-DD for days since 1970-01-01
+std::string civilFromDays(long z)
+{
+  z += 719468;
+  const long era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = (unsigned) (z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned m = mp + (mp < 10 ? 3 : -9);
+  const long y = (long) yoe + era * 400 + (m <= 2);
+  char date[48];
+  snprintf(date, sizeof(date), "%04ld-%02u-%02u", y, m, d);
+  return date;
+}
+
+// parse "YYYYMMDDHHMMSS,value" lines into points, dropping anything that doesn't make sense
+class LogParser {
+  // public class methods
+  public:
+    long linesParsed = 0;
+    long linesDropped = 0;
+
+    // clean log text for one file, sorted by time with duplicates removed
+    std::vector<Point> parse(const char* text, size_t length, const LogFile &logFile)
+    {
+      std::vector<Point> points;
+      const char* end = text + length;
+      const char* line = text;
+      while (line < end) {
+        const char* lineEnd = (const char*) memchr(line, '\n', end - line);
+        if (lineEnd == nullptr) {
+          lineEnd = end;
+        }
+        Point point;
+        if (this->parseLine(line, lineEnd, point) && point.value >= logFile.minValue && point.value <= logFile.maxValue) {
+          points.push_back(point);
+        } else if (lineEnd > line + 1) {
+          this->linesDropped += 1;
+        }
+        this->linesParsed += 1;
+        line = lineEnd + 1;
+      }
+
+      // OpenLog appends in order, but cards get merged and clocks get reset
+      std::stable_sort(points.begin(), points.end(), [](const Point &a, const Point &b) { return a.day < b.day; });
+      size_t before = points.size();
+      points.erase(std::unique(points.begin(), points.end(), [](const Point &a, const Point &b) { return a.day == b.day; }), points.end());
+      this->linesDropped += before - points.size();
+      return points;
+    }
+
+  // private class methods
+  private:
+    bool parseLine(const char* line, const char* lineEnd, Point &point)
+    {
+      // 14 digit timestamp, comma, value
+      if (lineEnd - line < 16 || line[14] != ',') {
+        return false;
+      }
+      int fields[6]; // year, month, day, hour, minute, second
+      const int widths[6] = {4, 2, 2, 2, 2, 2};
+      const char* c = line;
+      for (int i=0; i<6; i++)
+      {
+        fields[i] = 0;
+        for (int j=0; j<widths[i]; j++, c++)
+        {
+          if (*c < '0' || *c > '9') {
+            return false;
+          }
+          fields[i] = fields[i] * 10 + (*c - '0');
+        }
+      }
+      if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31 || fields[3] > 23 || fields[4] > 59 || fields[5] > 59) {
+        return false;
+      }
+
+      char* valueEnd;
+      long value = strtol(line + 15, &valueEnd, 10);
+      if (valueEnd == line + 15 || value == -999) {
+        return false;
+      }
+      while (valueEnd < lineEnd && (*valueEnd == '\r' || *valueEnd == ' ')) {
+        valueEnd++;
+      }
+      if (valueEnd != lineEnd) {
+        return false;
+      }
+      point.day = daysFromCivil(fields[0], fields[1], fields[2]) + (fields[3] * 3600 + fields[4] * 60 + fields[5]) / 86400.0;
+      point.value = (int) value;
+      return true;
+    }
+};
+
+// fit km per day since codes were last cleared and project the next oil change
+void predictOilChange(const std::vector<Point> &distance, VehicleResult &result)
+{
+  if (distance.empty()) {
+    return;
+  }
+
+  // distance since codes cleared drops back toward 0 when they are cleared (oil change): only use the latest run
+  size_t start = 0;
+  for (size_t i=1; i<distance.size(); i++)
+  {
+    if (distance[i].value < distance[i - 1].value) {
+      start = i;
+    }
+  }
+
+  // least squares line through km vs day
+  const size_t n = distance.size() - start;
+  double meanDay = 0;
+  double meanKm = 0;
+  for (size_t i=start; i<distance.size(); i++)
+  {
+    meanDay += distance[i].day;
+    meanKm += distance[i].value;
+  }
+  meanDay /= n;
+  meanKm /= n;
+  double covariance = 0;
+  double variance = 0;
+  for (size_t i=start; i<distance.size(); i++)
+  {
+    covariance += (distance[i].day - meanDay) * (distance[i].value - meanKm);
+    variance += (distance[i].day - meanDay) * (distance[i].day - meanDay);
+  }
+
+  result.lastDay = distance.back().day;
+  result.distanceKm = distance.back().value;
+  if (n < 2 || distance.back().day - distance[start].day < minFitDays || variance <= 0) {
+    return;
+  }
+  result.kmPerDay = covariance / variance;
+  if (result.kmPerDay <= 0) {
+    return;
+  }
+  result.daysToOilChange = std::max(0.0, (oilChangeIntervalKm - result.distanceKm) / result.kmPerDay);
+  result.hasPrediction = true;
+}
+
+// parse, clean and model one vehicle from its log file contents (empty string = file missing)
+VehicleResult processVehicle(const std::string &name, const std::vector<const std::string*> &files)
+{
+  VehicleResult result;
+  result.name = name;
+  LogParser parser;
+  for (int i=0; i<logFileCount; i++)
+  {
+    std::vector<Point> points = parser.parse(files[i]->data(), files[i]->size(), logFiles[i]);
+    if (i == distanceLogIndex) {
+      predictOilChange(points, result);
+    }
+  }
+  result.linesParsed = parser.linesParsed;
+  result.linesDropped = parser.linesDropped;
+  return result;
+}
+
+// fixed set of threads, each with its own queue, stealing from the others once theirs is empty
+class WorkStealingPool {
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+  std::vector<Queue> queues;
+  size_t nextQueue = 0; // round-robin for submit()
+
+  // public class methods
+  public:
+    // constructor
+    WorkStealingPool(size_t threadCount): queues(threadCount)
+    {
+    }
+
+    // queue a task before run()
+    void submit(std::function<void()> task)
+    {
+      this->queues[this->nextQueue].tasks.push_back(std::move(task));
+      this->nextQueue = (this->nextQueue + 1) % this->queues.size();
+    }
+
+    // run every queued task and wait for all of them
+    void run()
+    {
+      std::vector<std::thread> threads;
+      for (size_t i=0; i<this->queues.size(); i++)
+      {
+        threads.emplace_back([this, i]() { this->work(i); });
+      }
+      for (std::thread &thread : threads)
+      {
+        thread.join();
+      }
+    }
+
+  // private class methods
+  private:
+    void work(size_t self)
+    {
+      std::function<void()> task;
+      // tasks don't queue more tasks, so once every queue is empty we're done
+      while (this->popOwn(self, task) || this->steal(self, task)) {
+        task();
+      }
+    }
+
+    // newest first from our own queue
+    bool popOwn(size_t self, std::function<void()> &task)
+    {
+      Queue &queue = this->queues[self];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        return false;
+      }
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+
+    // oldest first from someone else's
+    bool steal(size_t self, std::function<void()> &task)
+    {
+      for (size_t i=1; i<this->queues.size(); i++)
+      {
+        Queue &queue = this->queues[(self + i) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+          task = std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+};
+
+// process every vehicle on threadCount threads, results in the same order as the vehicles
+// files holds logFileCount entries per vehicle
+std::vector<VehicleResult> processFleet(const std::vector<std::string> &names, const std::vector<const std::string*> &files, size_t threadCount)
+{
+  std::vector<VehicleResult> results(names.size());
+  WorkStealingPool pool(threadCount);
+  for (size_t i=0; i<names.size(); i++)
+  {
+    pool.submit([&, i]() {
+      std::vector<const std::string*> vehicleFiles(files.begin() + i * logFileCount, files.begin() + (i + 1) * logFileCount);
+      results[i] = processVehicle(names[i], vehicleFiles);
+    });
+  }
+  pool.run();
+  return results;
+}
+
+// fleet-wide statistics on stderr
+void printSummary(const std::vector<VehicleResult> &results, double seconds, size_t threadCount)
+{
+  long linesParsed = 0;
+  long linesDropped = 0;
+  std::vector<double> kmPerDay;
+  int dueIn7Days = 0;
+  int dueIn30Days = 0;
+  for (const VehicleResult &result : results)
+  {
+    linesParsed += result.linesParsed;
+    linesDropped += result.linesDropped;
+    if (result.hasPrediction) {
+      kmPerDay.push_back(result.kmPerDay);
+      dueIn7Days += result.daysToOilChange <= 7;
+      dueIn30Days += result.daysToOilChange <= 30;
+    }
+  }
+  std::sort(kmPerDay.begin(), kmPerDay.end());
+  double meanKmPerDay = 0;
+  for (double rate : kmPerDay)
+  {
+    meanKmPerDay += rate;
+  }
+  meanKmPerDay = kmPerDay.empty() ? 0 : meanKmPerDay / kmPerDay.size();
+
+  fprintf(stderr, "vehicles: %zu (%zu with a prediction)\n", results.size(), kmPerDay.size());
+  fprintf(stderr, "lines: %ld parsed, %ld dropped\n", linesParsed, linesDropped);
+  if (!kmPerDay.empty()) {
+    fprintf(stderr, "km/day: mean %.1f, median %.1f, min %.1f, max %.1f\n", meanKmPerDay, kmPerDay[kmPerDay.size() / 2], kmPerDay.front(), kmPerDay.back());
+  }
+  fprintf(stderr, "oil change due: %d within 7 days, %d within 30 days\n", dueIn7Days, dueIn30Days);
+  fprintf(stderr, "%.3fs on %zu threads (%.0f vehicles/s)\n", seconds, threadCount, results.size() / seconds);
+}
+
+// read a whole file, empty if missing
+std::string readFile(const fs::path &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+void printUsage(const char* program)
+{
+  fprintf(stderr, "usage: %s <fleet dir> [threads]\n       %s --bench <vehicles> [lines per file]  (in memory, no file I/O)\n", program, program);
+}
+
+int runFleet(const char* program, const char* fleetDir, size_t threadCount)
+{
+  // a missing or unreadable fleet dir is a usage error, not a crash
+  std::error_code error;
+  fs::directory_iterator entries(fleetDir, error);
+  if (error) {
+    fprintf(stderr, "%s: %s\n", fleetDir, error.message().c_str());
+    printUsage(program);
+    return 1;
+  }
+  std::vector<fs::path> vehicleDirs;
+  for (; entries != fs::directory_iterator(); entries.increment(error))
+  {
+    if (error) {
+      fprintf(stderr, "%s: %s\n", fleetDir, error.message().c_str());
+      return 1;
+    }
+    if (entries->is_directory(error)) {
+      vehicleDirs.push_back(entries->path());
+    }
+  }
+  std::sort(vehicleDirs.begin(), vehicleDirs.end());
+
+  const auto startTime = std::chrono::steady_clock::now();
+
+  // reading is part of the parallel work too: one task per vehicle loads its card, then it's processed
+  std::vector<VehicleResult> results(vehicleDirs.size());
+  WorkStealingPool pool(threadCount);
+  for (size_t i=0; i<vehicleDirs.size(); i++)
+  {
+    pool.submit([&, i]() {
+      std::vector<std::string> contents(logFileCount);
+      std::vector<const std::string*> files(logFileCount);
+      for (int j=0; j<logFileCount; j++)
+      {
+        contents[j] = readFile(vehicleDirs[i] / logFiles[j].name);
+        files[j] = &contents[j];
+      }
+      results[i] = processVehicle(vehicleDirs[i].filename().string(), files);
+    });
+  }
+  pool.run();
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  printf("vehicle,lastReading,distanceSinceClearedKm,kmPerDay,daysToOilChange,nextOilChange\n");
+  for (const VehicleResult &result : results)
+  {
+    if (result.hasPrediction) {
+      printf("%s,%s,%d,%.1f,%.1f,%s\n", result.name.c_str(), civilFromDays((long) result.lastDay).c_str(), result.distanceKm,
+        result.kmPerDay, result.daysToOilChange, civilFromDays((long) (result.lastDay + result.daysToOilChange)).c_str());
+    } else {
+      printf("%s,%s,%d,,,\n", result.name.c_str(), result.lastDay > 0 ? civilFromDays((long) result.lastDay).c_str() : "", result.distanceKm);
+    }
+  }
+  printSummary(results, seconds, threadCount);
+  return 0;
+}
+
+// a synthetic log: a reading every 10 minutes while driving a couple of hours a day, plus some junk lines
+std::string syntheticLog(int logIndex, int seed, int lineCount)
+{
+  std::string log;
+  log.reserve(lineCount * 24);
+  unsigned int state = seed * 2654435761u + logIndex;
+  const double kmPerReading = 2 + seed % 7; // 12 - 48 km/h average
+  long day = daysFromCivil(2019, 11, 1);
+  int minute = 7 * 60;
+  int distance = 1000 + seed % 3000;
+  char line[64];
+  for (int i=0; i<lineCount; i++)
+  {
+    state = state * 1103515245u + 12345u;
+    int value;
+    if (logIndex == distanceLogIndex) {
+      distance += (int) kmPerReading + (state >> 16) % 3;
+      value = distance;
+    } else {
+      value = logFiles[logIndex].minValue + (state >> 16) % (logFiles[logIndex].maxValue - logFiles[logIndex].minValue + 1);
+    }
+    if ((state >> 8) % 50 == 0) {
+      value = -999; // failed request
+    }
+    std::string date = civilFromDays(day);
+    snprintf(line, sizeof(line), "%.4s%.2s%.2s%02d%02d00,%d\n", date.c_str(), date.c_str() + 5, date.c_str() + 8, minute / 60, minute % 60, value);
+    log += line;
+    minute += 10;
+    if (minute >= 9 * 60) {
+      // two hours of driving a day
+      minute = 7 * 60;
+      day += 1;
+    }
+  }
+  log += "garbage line\n";
+  return log;
+}
+
+int runBenchmark(size_t vehicleCount, int lineCount)
+{
+  // a pool of distinct cards shared round-robin keeps memory flat for 10k vehicles while the work stays real
+  const int distinctCards = 64;
+  std::vector<std::string> cards(distinctCards * logFileCount);
+  for (int c=0; c<distinctCards; c++)
+  {
+    for (int j=0; j<logFileCount; j++)
+    {
+      cards[c * logFileCount + j] = syntheticLog(j, c, lineCount);
+    }
+  }
+  std::vector<std::string> names(vehicleCount);
+  std::vector<const std::string*> files(vehicleCount * logFileCount);
+  for (size_t i=0; i<vehicleCount; i++)
+  {
+    names[i] = "vehicle" + std::to_string(i);
+    for (int j=0; j<logFileCount; j++)
+    {
+      files[i * logFileCount + j] = &cards[(i % distinctCards) * logFileCount + j];
+    }
+  }
+
+  const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  fprintf(stderr, "synthetic fleet: %zu vehicles sharing %d cached cards, %d lines per file, %zu cores (parsing only, no file I/O)\n",
+    vehicleCount, distinctCards, lineCount, cores);
+  double baseSeconds = 0;
+  for (size_t threadCount=1; ; threadCount = std::min(threadCount * 2, cores))
+  {
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<VehicleResult> results = processFleet(names, files, threadCount);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    if (threadCount == 1) {
+      baseSeconds = seconds;
+    }
+    fprintf(stderr, "threads %3zu: %8.3fs %10.0f vehicles/s  speedup %5.2fx (%3.0f%% of linear)\n", threadCount, seconds,
+      vehicleCount / seconds, baseSeconds / seconds, 100 * baseSeconds / seconds / threadCount);
+    if (threadCount == cores) {
+      printSummary(results, seconds, threadCount);
+      break;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc >= 3 && strcmp(argv[1], "--bench") == 0) {
+    return runBenchmark(strtoul(argv[2], nullptr, 10), argc >= 4 ? atoi(argv[3]) : 1000);
+  }
+  if (argc < 2) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  size_t threadCount = argc >= 3 ? strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+  return runFleet(argv[0], argv[1], std::max<size_t>(1, threadCount));
+}
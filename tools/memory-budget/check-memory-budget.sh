@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+# check-memory-budget.sh - Build car-psychic.ino for the MCU and gate its static RAM (.data + .bss of the .elf) so
+# STACK_BUDGET_BYTES (MemoryBudget.h) of the SRAM stays free for stack and heap
+#
+# Usage:
+#   check-memory-budget.sh   print the largest RAM users, exit 1 when .data + .bss is over RAM_BYTES - STACK_BUDGET_BYTES
+#
+# The sketch's static_assert only sees sizeof() of its subsystems plus the known library statics, this sees everything:
+# string literals and vtables (in .data on AVR), core and library globals, Serial/Wire buffers and the OLED screen buffer.
+# Needs on PATH: arduino-cli (core for FQBN and the SparkFun libraries the sketch includes) and the core's size/nm tools.
+# Defaults to the Leonardo: the same atmega32u4 (2560 bytes SRAM) as the SparkFun Qwiic Pro Micro. For other boards set
+# FQBN, RAM_BYTES to its SRAM, and SIZE/NM (e.g. arm-none-eabi-size/arm-none-eabi-nm).
+set -euo pipefail
+
+here="$(cd "$(dirname "$0")" && pwd)"
+repo="$(cd "$here/../.." && pwd)"
+fqbn="${FQBN:-arduino:avr:leonardo}"
+ramBytes="${RAM_BYTES:-2560}"
+size="${SIZE:-avr-size}"
+nm="${NM:-avr-nm}"
+build="$here/build"
+stackBytes="$(sed -n 's/^ *#define STACK_BUDGET_BYTES \([0-9]*\).*/\1/p' "$repo/MemoryBudget.h" | head -n 1)"
+
+if [ $# -gt 0 ]; then
+  echo "usage: $0" >&2
+  exit 2
+fi
+
+# arduino-cli wants the sketch in a folder of the same name, whatever the clone is called
+sketch="$build/car-psychic"
+rm -rf "$sketch"
+mkdir -p "$sketch"
+cp "$repo"/*.ino "$repo"/*.h "$sketch/"
+arduino-cli compile -b "$fqbn" --output-dir "$build" "$sketch" > /dev/null
+elf="$build/car-psychic.ino.elf"
+
+# initialised (.data, .relocate on SAMD) and zeroed (.bss) static RAM
+read -r data bss <<< "$("$size" -A "$elf" | awk '
+  $1 == ".data" || $1 == ".relocate" { data += $2 }
+  $1 == ".bss" { bss += $2 }
+  END { print data + 0, bss + 0 }
+')"
+used=$((data + bss))
+limit=$((ramBytes - stackBytes))
+
+# one line per global: the sketch's subsystems by name, library buffers, vtables and string literal pools
+echo "largest RAM users (bytes):"
+"$nm" -S -C -t d "$elf" | awk '$3 ~ /^[bBdD]$/ { size = $2; $1 = $2 = $3 = ""; sub(/^ +/, ""); printf "  %6d %s\n", size, $0 }' | sort -rn | head -n 25
+
+echo ".data $data + .bss $bss = $used bytes, budget $limit ($ramBytes SRAM - $stackBytes STACK_BUDGET_BYTES)"
+if [ "$used" -gt "$limit" ]; then
+  echo "FAIL: static RAM is $((used - limit)) bytes over budget, stack and heap would run into it" >&2
+  exit 1
+fi
+echo "MEMORY BUDGET PASSED"